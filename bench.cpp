@@ -0,0 +1,759 @@
+/*
+ * Benchmarks for the to-do list code
+ *
+ *   bench parse [lines]    tasks.txt loading: old getline+substr+stoi loop
+ *                          against the chunked parser in task_text.h
+ *   bench stress [tasks] [ops per thread]
+ *                          ConcurrentTaskList (task_concurrent.h) under a
+ *                          mixed workload on 1, 2, 4, 8 and 16 threads
+ *   bench scan [tasks]     filterSlots (task_parallel.h) serial and on
+ *                          pools of 2, 4 and 8 threads
+ *   bench search [tasks]   TextIndex (task_index.h) queries against a
+ *                          linear scan of every description
+ *   bench map [tasks...]   FlatIdMap (task_idmap.h) against unordered_map:
+ *                          insert, hit/miss lookups and erase (default
+ *                          10k, 1M and 10M ids)
+ *   bench engine [tasks]   TaskEngine (task_engine.h), in memory and with no
+ *                          output: bulk add, complete, clear, undo / redo,
+ *                          delete, search and priority listings
+ *   bench variants [tasks] the same for each engine configuration
+ *                          (task_policy.h): hash index, heap nodes, no
+ *                          priority index, LeanTaskEngine, SharedTaskEngine
+ *   bench workload [tasks...] [--ops=N]
+ *                          synthetic workloads on TaskEngine at each size
+ *                          (default 1k, 100k, 1M): throughput, p50/p99
+ *                          latency per operation and peak RSS, to compare
+ *                          builds against each other
+ *   bench lists [lists] [tasks per list] [--open=N]
+ *                          TaskListCache (task_server.h): many lists on
+ *                          disk, at most N loaded, random access with LRU
+ *                          eviction; hit / miss latency and peak RSS
+ *   bench gen <commands> [file|-]
+ *                          write a random batch file (task_batch.h) for
+ *                          `todo --batch` / `todolist --batch`
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -o bench bench.cpp
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <sys/resource.h>
+#include "task_text.h"
+#include "task_concurrent.h"
+#include "task_parallel.h"
+#include "task_index.h"
+#include "task_idmap.h"
+#include "task_engine.h"
+#include "task_server.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+// run 'fn' a few times and keep the best time (ms)
+template <class Fn>
+double bestOf(int runs, Fn fn) {
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        Clock::time_point start = Clock::now();
+        fn();
+        best = min(best, msSince(start));
+    }
+    return best;
+}
+
+// ================================
+// parse: text loader
+// ================================
+
+// the loop loadFromFile used before task_text.h, kept as the baseline
+long long legacyParse(const string& path) {
+    ifstream fin(path);
+    long long checksum = 0;
+    string line;
+    while (getline(fin, line)) {
+        if (line.empty()) continue;
+        size_t p1 = line.find('|');
+        size_t p2 = line.find('|', p1 + 1);
+        size_t p3 = line.find('|', p2 + 1);
+        if (p1 == string::npos || p2 == string::npos || p3 == string::npos) continue;
+
+        int id = stoi(line.substr(0, p1));
+        string desc = line.substr(p1 + 1, p2 - p1 - 1);
+        int prio = stoi(line.substr(p2 + 1, p3 - p2 - 1));
+        int done = stoi(line.substr(p3 + 1));
+        checksum += id + prio + done + (long long)desc.size();
+    }
+    return checksum;
+}
+
+long long fastParse(const string& path) {
+    long long checksum = 0;
+    vector<ParseError> errors;
+    parseTaskFile(path, [&](const TextTaskRecord& r) {
+        checksum += r.id + r.priority + (r.completed ? 1 : 0) + (long long)r.description.size();
+    }, errors);
+    return checksum;
+}
+
+void writeTaskFile(const string& path, size_t lines) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        cout << "✗ Unable to create " << path << "\n";
+        exit(1);
+    }
+    srand(42);
+    for (size_t i = 1; i <= lines; i++) {
+        fprintf(f, "%zu|Task number %zu from the nightly import batch|%d|%d\n",
+                i, i, rand() % 5 + 1, rand() % 2);
+    }
+    fclose(f);
+}
+
+void benchParse(size_t lines) {
+    string path = (filesystem::temp_directory_path() / "bench_tasks.txt").string();
+    writeTaskFile(path, lines);
+    double mb = filesystem::file_size(path) / (1024.0 * 1024.0);
+
+    long long a = 0, b = 0;
+    double legacyMs = bestOf(3, [&] { a = legacyParse(path); });
+    double fastMs = bestOf(3, [&] { b = fastParse(path); });
+    remove(path.c_str());
+
+    cout << "parse " << lines << " lines (" << (int)mb << " MB)\n";
+    cout << "  getline+substr+stoi: " << legacyMs << " ms  (" << lines / legacyMs / 1000.0 << " M lines/s)\n";
+    cout << "  chunked from_chars:  " << fastMs << " ms  (" << lines / fastMs / 1000.0 << " M lines/s)\n";
+    cout << "  speedup: " << legacyMs / fastMs << "x" << (a == b ? "" : "  ✗ checksums differ!") << "\n";
+}
+
+// ================================
+// stress: concurrent task list
+// ================================
+
+// small per-thread random generator (rand() has shared state)
+struct XorShift {
+    uint64_t s;
+    explicit XorShift(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return (uint32_t)(s >> 32);
+    }
+};
+
+// per 1000 ops: 900 lookups, 80 completions, 10 adds, 9 deletes, 1 full scan
+void stressWorker(ConcurrentTaskList& list, int tasks, int ops, uint64_t seed, long long& checksum) {
+    XorShift rng(seed);
+    TaskInfo info;
+    long long sum = 0;
+    for (int i = 0; i < ops; i++) {
+        uint32_t r = rng.next() % 1000;
+        int id = (int)(rng.next() % (uint32_t)tasks) + 1;
+        if (r < 900) {
+            if (list.find(id, info)) sum += info.priority;
+        }
+        else if (r < 980) sum += list.setCompleted(id, (r & 1) != 0);
+        else if (r < 990) sum += list.add("task added by a stress worker", (int)(r % 5) + 1) > 0;
+        else if (r < 999) sum += list.remove(id);
+        else {
+            int pending = 0;
+            list.forEach([&](int, string_view, int, bool done) { pending += !done; });
+            sum += pending;
+        }
+    }
+    checksum = sum;
+}
+
+void benchStress(int tasks, int opsPerThread) {
+    cout << "stress: " << tasks << " tasks, " << opsPerThread << " ops per thread ("
+         << thread::hardware_concurrency() << " hardware threads)\n";
+    double base = 0;
+    for (int threads : { 1, 2, 4, 8, 16 }) {
+        ConcurrentTaskList list;
+        for (int i = 1; i <= tasks; i++) list.add("Task number " + to_string(i), i % 5 + 1);
+
+        vector<thread> workers;
+        vector<long long> sums(threads);
+        Clock::time_point start = Clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back(stressWorker, ref(list), tasks, opsPerThread, (uint64_t)t + 1, ref(sums[t]));
+        }
+        for (thread& w : workers) w.join();
+        double ms = msSince(start);
+
+        // the running counters must agree with a scan once the workers are done
+        int live = 0, done = 0;
+        list.forEach([&](int, string_view, int, bool d) { live++; done += d; });
+        TaskCounts c = list.counts();
+        bool consistent = c.live == live && c.done == done;
+
+        double mops = (double)threads * opsPerThread / ms / 1000.0;
+        if (threads == 1) base = mops;
+        cout << "  " << threads << " thread(s): " << ms << " ms, " << mops << " M ops/s ("
+             << mops / base << "x)" << (consistent ? "" : "  ✗ counters differ from a scan!") << "\n";
+    }
+}
+
+// ================================
+// scan: parallel filtering
+// ================================
+void benchScan(int tasks) {
+    TaskStore store;
+    store.reserve(tasks);
+    srand(7);
+    for (int i = 1; i <= tasks; i++) store.add(i, "Task", rand() % 5 + 1, rand() % 3 == 0);
+    auto pending = [&](int s) { return store.flags[s] == TaskStore::LIVE; };
+
+    size_t expected = 0;
+    double serialMs = bestOf(5, [&] { expected = filterSlots(store, nullptr, pending).size(); });
+    cout << "scan " << tasks << " tasks for pending ones (" << thread::hardware_concurrency()
+         << " hardware threads)\n";
+    cout << "  serial:     " << serialMs << " ms\n";
+    for (int threads : { 2, 4, 8 }) {
+        WorkerPool pool(threads);
+        size_t got = 0;
+        double ms = bestOf(5, [&] { got = filterSlots(store, &pool, pending).size(); });
+        cout << "  " << threads << " threads:  " << ms << " ms (" << serialMs / ms << "x)"
+             << (got == expected ? "" : "  ✗ results differ!") << "\n";
+    }
+}
+
+// ================================
+// search: inverted index
+// ================================
+
+// does 'desc' contain 'word' as a whole token (the scan the index replaces)
+bool hasToken(string_view desc, const string& word) {
+    bool found = false;
+    forEachToken(desc, [&](const string& t) { found = found || t == word; });
+    return found;
+}
+
+void benchSearch(int tasks) {
+    // a Zipf-ish vocabulary: a few common words, a long tail of rare ones
+    static const char* common[] = { "buy", "call", "email", "fix", "review", "write", "plan", "clean" };
+    XorShift rng(11);
+    vector<string> descs(tasks);
+    for (int i = 0; i < tasks; i++) {
+        descs[i] = string(common[rng.next() % 8]) + " " + common[rng.next() % 8] + " item" +
+                   to_string(rng.next() % 5000) + " note" + to_string(rng.next() % 200000);
+    }
+
+    TextIndex index;
+    index.markBuilt();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < tasks; i++) index.add(i + 1, descs[i]);
+    cout << "search " << tasks << " tasks (" << index.tokenCount() << " distinct tokens)\n";
+    cout << "  build index:       " << msSince(start) << " ms\n";
+
+    struct Query { const char* text; vector<string> words; };
+    const Query queries[] = {
+        { "note123", { "note123" } },
+        { "buy item42", { "buy", "item42" } },
+        { "review fix note7*", {} },
+        { "item49*", {} },
+    };
+    for (const Query& q : queries) {
+        size_t hits = 0;
+        double indexMs = bestOf(5, [&] { hits = index.search(q.text).size(); });
+        cout << "  \"" << q.text << "\": " << hits << " hit(s), " << indexMs * 1000.0 << " us";
+        if (!q.words.empty()) {      // exact words only: check against a scan
+            size_t scanned = 0;
+            double scanMs = bestOf(1, [&] {
+                scanned = 0;
+                for (const string& d : descs) {
+                    bool all = true;
+                    for (const string& w : q.words) all = all && hasToken(d, w);
+                    scanned += all;
+                }
+            });
+            cout << " (scan " << scanMs << " ms, " << scanMs / indexMs << "x)"
+                 << (scanned == hits ? "" : "  ✗ results differ!");
+        }
+        cout << "\n";
+    }
+}
+
+// ================================
+// map: id -> node index
+// ================================
+
+// ns per operation for each phase, with the same ids fed to both maps:
+// ids 1..n inserted in order (like nextId), looked up and erased in random order
+template <class Map, class Find, class Insert>
+void timeIdMap(const char* name, const vector<int>& shuffled, Find find, Insert insert) {
+    int n = (int)shuffled.size();
+    Map map;
+    long long sum = 0;
+    Clock::time_point t = Clock::now();
+    for (int id = 1; id <= n; id++) insert(map, id);
+    double insertMs = msSince(t);
+
+    t = Clock::now();
+    for (int id : shuffled) sum += find(map, id) != nullptr;
+    double hitMs = msSince(t);
+
+    t = Clock::now();
+    for (int id : shuffled) sum += find(map, id + n) != nullptr;     // none of these exist
+    double missMs = msSince(t);
+
+    t = Clock::now();
+    for (int id : shuffled) map.erase(id);
+    double eraseMs = msSince(t);
+
+    double perOp = 1e6 / n;
+    cout << "  " << name << " insert " << insertMs * perOp << " ns, hit " << hitMs * perOp << " ns, miss "
+         << missMs * perOp << " ns, erase " << eraseMs * perOp << " ns"
+         << (sum == n && map.size() == 0 ? "" : "  ✗ wrong results!") << "\n";
+}
+
+void benchMap(int tasks) {
+    vector<int> shuffled(tasks);
+    for (int i = 0; i < tasks; i++) shuffled[i] = i + 1;
+    XorShift rng(5);
+    for (int i = tasks - 1; i > 0; i--) swap(shuffled[i], shuffled[rng.next() % (uint32_t)(i + 1)]);
+
+    static int node;        // stands in for a Node*
+    cout << "map " << tasks << " ids\n";
+    // FlatIdMap first: after millions of unordered_map nodes are freed, the
+    // heap they leave behind slows down whichever map is timed next
+    timeIdMap<FlatIdMap<int*>>("FlatIdMap:    ", shuffled,
+        [](FlatIdMap<int*>& m, int id) -> int* {
+            int** found = m.find(id);
+            return found ? *found : nullptr;
+        },
+        [](FlatIdMap<int*>& m, int id) { m.insert(id, &node); });
+    timeIdMap<unordered_map<int, int*>>("unordered_map:", shuffled,
+        [](unordered_map<int, int*>& m, int id) -> int* {
+            auto it = m.find(id);
+            return it == m.end() ? nullptr : it->second;
+        },
+        [](unordered_map<int, int*>& m, int id) { m.emplace(id, &node); });
+}
+
+// ================================
+// engine: the operations behind both front ends, no terminal output
+// ================================
+template <class Engine>
+void benchEngine(const char* name, int tasks) {
+    vector<string> descs(tasks);
+    for (int i = 0; i < tasks; i++) descs[i] = "task " + to_string(i) + (i % 2 ? " review notes" : " buy milk");
+    vector<NewTask> batch(tasks);
+    for (int i = 0; i < tasks; i++) batch[i] = NewTask{ descs[i], i % 5 + 1 };
+    vector<int> everyThird, everyOther;
+    for (int id = 1; id <= tasks; id += 3) everyThird.push_back(id);
+    for (int id = 2; id <= tasks; id += 2) everyOther.push_back(id);
+
+    Engine engine;
+    cout << name << " " << tasks << " tasks\n";
+    auto step = [&](const char* name, auto fn) {
+        Clock::time_point start = Clock::now();
+        bool good = fn();
+        cout << "  " << name << msSince(start) << " ms" << (good ? "" : "  ✗ wrong result!") << "\n";
+    };
+    step("add (one bulk call):  ", [&] { return engine.addTasks(batch.data(), batch.size()).applied == tasks; });
+    step("add (one at a time):  ", [&] {
+        for (int i = 0; i < tasks; i++) engine.add(descs[i], 3);
+        return engine.count() == 2 * tasks;
+    });
+    step("complete every 3rd:   ", [&] {
+        return engine.completeMany(everyThird.data(), everyThird.size()).applied == (int)everyThird.size();
+    });
+    step("clear completed:      ", [&] { return engine.removeCompleted() == (int)everyThird.size(); });
+    step("undo the clear:       ", [&] { return engine.undo().applied == (int)everyThird.size(); });
+    step("redo the clear:       ", [&] { return engine.redo().applied == (int)everyThird.size(); });
+    step("delete every 2nd:     ", [&] {
+        int live = engine.count();
+        BulkResult r = engine.deleteMany(everyOther.data(), everyOther.size());
+        return engine.count() == live - r.applied;
+    });
+    step("undo the delete:      ", [&] { return engine.undo().applied > 0; });
+    step("first search (index): ", [&] { return !engine.search("review").empty(); });
+    step("search two words:     ", [&] { return !engine.search("buy milk").empty(); });
+    static const int urgentFirst[5] = { 1, 2, 3, 4, 5 };
+    step("top 10 pending x1000: ", [&] {
+        size_t found = 0;
+        for (int i = 0; i < 1000; i++) found += engine.tasks().topPending(10, urgentFirst).size();
+        return found == 10000;
+    });
+    step("walk by priority:     ", [&] {
+        long long visited = 0;
+        for (int p = 1; p <= 5; p++) engine.tasks().forEachInPriority(p, [&](int) { visited++; return true; });
+        return visited == engine.count();
+    });
+    step("first page (ranks):   ", [&] { return engine.page(PageView::All, 0, 20).slots.size() == 20; });
+    step("1000 pages, pending:  ", [&] {
+        size_t pages = (size_t)(engine.tasks().liveCount - engine.tasks().doneCount) / 20, shown = 0;
+        for (size_t i = 0; i < 1000; i++) shown += engine.page(PageView::Pending, i * 7919 % pages, 20).slots.size();
+        return shown == 20000;
+    });
+    step("next page x1000, p3:  ", [&] {
+        TaskPage page = engine.page(PageView::Priority, 0, 20, 3);
+        size_t shown = page.slots.size();
+        for (int i = 0; i < 1000 && !page.atEnd(); i++) shown += (page = engine.nextPage(page)).slots.size();
+        return shown > 0;
+    });
+    step("set 1000 deadlines:   ", [&] {
+        vector<int> ids;
+        for (const TaskNode* cur = engine.front(); cur && ids.size() < 1000; cur = cur->next) ids.push_back(cur->id);
+        int set = 0;
+        for (int id : ids) set += engine.setDeadline(id, (int64_t)(1 + id % 90) * 86400);
+        return set == 1000;
+    });
+    step("next (builds queue):  ", [&] { return engine.peekNext() != 0; });
+    step("pop next x1000:       ", [&] {
+        int popped = 0;
+        for (int i = 0; i < 1000; i++) popped += engine.popNext() != 0;
+        return popped == 1000;
+    });
+}
+
+// every engine configuration in task_policy.h that is worth comparing
+void benchVariants(int tasks) {
+    benchEngine<TaskEngine>("TaskEngine (flat map, slabs, priority lists)", tasks);
+    benchEngine<BasicTaskEngine<HashIndex>>("HashIndex", tasks);
+    benchEngine<BasicTaskEngine<FlatIndex, HeapNodes>>("HeapNodes", tasks);
+    benchEngine<BasicTaskEngine<FlatIndex, SlabNodes, SingleThreaded, WithoutPriorityIndex>>("WithoutPriorityIndex", tasks);
+    benchEngine<LeanTaskEngine>("LeanTaskEngine", tasks);
+    benchEngine<SharedTaskEngine>("SharedTaskEngine (locked)", tasks);
+    benchEngine<HostedTaskEngine>("HostedTaskEngine (shared node arena)", tasks);
+}
+
+// ================================
+// workload: throughput, latency percentiles and peak RSS
+// ================================
+
+// latencies of one kind of operation
+struct Latencies {
+    vector<double> ns;
+
+    template <class Fn>
+    void time(Fn fn) {
+        Clock::time_point start = Clock::now();
+        fn();
+        ns.push_back(chrono::duration<double, nano>(Clock::now() - start).count());
+    }
+
+    // q in [0, 1]; reorders the samples
+    double percentile(double q) {
+        if (ns.empty()) return 0;
+        size_t k = min(ns.size() - 1, (size_t)(q * ns.size()));
+        nth_element(ns.begin(), ns.begin() + (ptrdiff_t)k, ns.end());
+        return ns[k];
+    }
+
+    double totalMs() const {
+        double sum = 0;
+        for (double v : ns) sum += v;
+        return sum / 1e6;
+    }
+};
+
+// highest resident set size of this process so far
+double peakRssMiB() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return ru.ru_maxrss / (1024.0 * 1024.0);   // bytes
+#else
+    return ru.ru_maxrss / 1024.0;              // KiB
+#endif
+}
+
+void reportOps(const char* name, Latencies& lat) {
+    size_t n = lat.ns.size();
+    double ms = lat.totalMs();
+    cout << "  " << name << n << " ops, " << (ms > 0 ? n / ms / 1000.0 : 0) << " M ops/s, p50 "
+         << lat.percentile(0.50) << " ns, p99 " << lat.percentile(0.99) << " ns\n";
+}
+
+// one call over 'tasks' tasks
+void reportBulk(const char* name, size_t tasks, double ms, bool good) {
+    cout << "  " << name << ms << " ms, " << (ms > 0 ? tasks / ms / 1000.0 : 0) << " M tasks/s"
+         << (good ? "" : "  ✗ wrong result!") << "\n";
+}
+
+void benchWorkload(int tasks, int ops) {
+    namespace fs = std::filesystem;
+    XorShift rng(17);
+    vector<string> descs(tasks);
+    for (int i = 0; i < tasks; i++) descs[i] = "Task number " + to_string(i) + " from the nightly import batch";
+    vector<NewTask> batch(tasks);
+    for (int i = 0; i < tasks; i++) batch[i] = NewTask{ descs[i], (int)(rng.next() % 5) + 1 };
+    auto randomId = [&] { return (int)(rng.next() % (uint32_t)tasks) + 1; };
+
+    cout << "workload " << tasks << " tasks, " << ops << " ops per operation\n";
+    TaskEngine engine;
+
+    Clock::time_point start = Clock::now();
+    bool good = engine.addTasks(batch.data(), batch.size()).applied == tasks;
+    reportBulk("bulk add:           ", tasks, msSince(start), good);
+
+    Latencies add;
+    for (int i = 0; i < ops; i++) add.time([&] { engine.add(descs[i % tasks], 3); });
+    reportOps("add:                ", add);
+
+    Latencies complete;
+    for (int i = 0; i < ops; i++) {
+        int id = randomId();
+        bool done = rng.next() % 4 != 0;
+        complete.time([&] { engine.setCompleted(id, done); });
+    }
+    reportOps("markComplete:       ", complete);
+
+    // delete a random task, and every other time undo the last delete
+    Latencies del, undo;
+    for (int i = 0; i < ops; i++) {
+        int id = randomId();
+        del.time([&] { engine.remove(id); });
+        if (i % 2) undo.time([&] { engine.undo(); });
+    }
+    reportOps("delete:             ", del);
+    reportOps("undo delete:        ", undo);
+
+    int total = engine.count();
+    int done = engine.tasks().doneCount;
+    start = Clock::now();
+    good = engine.removeCompleted() == done;
+    reportBulk("deleteAllCompleted: ", total, msSince(start), good);
+    start = Clock::now();
+    good = engine.undo().applied == done && engine.count() == total;
+    reportBulk("undo the clear:     ", total, msSince(start), good);
+
+    // file round-trips in a scratch directory
+    fs::path dir = fs::temp_directory_path() / "bench_workload";
+    error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    StorageFiles files;
+    files.snapshot = (dir / "tasks.bin").string();
+    files.text = (dir / "tasks.txt").string();
+    files.log = (dir / "tasks.log").string();
+
+    start = Clock::now();
+    good = engine.exportText(files.text);
+    reportBulk("saveToFile:         ", total, msSince(start), good);
+    // the same save handed to the background writer: the caller only pays for the copy
+    start = Clock::now();
+    engine.exportTextInBackground(files.text);
+    double queued = msSince(start);
+    engine.flushSaves();
+    reportBulk("save in background: ", total, queued, engine.failedSaves().empty());
+    reportBulk("  ... until written:", total, msSince(start), true);
+    {
+        TaskEngine loaded;
+        loaded.setStorageFiles(files);
+        start = Clock::now();
+        LoadReport r = loaded.load();   // writes the first tasks.bin too
+        reportBulk("loadFromFile (+bin):", total, msSince(start), loaded.count() == total && r.textErrors.empty());
+        loaded.update(loaded.front()->id, "renamed by the benchmark", 0);  // a new description: the whole file
+        start = Clock::now();
+        good = loaded.checkpoint();
+        reportBulk("save snapshot:      ", total, msSince(start), good);
+        // one task changed since: only its record is rewritten
+        loaded.setCompleted(loaded.front()->id, !loaded.tasks().isCompleted(loaded.front()->slot));
+        start = Clock::now();
+        good = loaded.checkpoint();
+        reportBulk("save one change:    ", total, msSince(start), good);
+    }
+    {
+        TaskEngine loaded;
+        loaded.setStorageFiles(files);
+        start = Clock::now();
+        LoadReport r = loaded.load();
+        reportBulk("load snapshot:      ", total, msSince(start), r.fromSnapshot && loaded.count() == total);
+    }
+    // the same two loads borrowing the descriptions from the files (TaskEngine::setLazyLoad)
+    fs::remove(files.snapshot, ec);
+    {
+        TaskEngine loaded;
+        loaded.setStorageFiles(files);
+        loaded.setLazyLoad(true);
+        start = Clock::now();
+        LoadReport r = loaded.load();
+        reportBulk("lazy text (+bin):   ", total, msSince(start), loaded.count() == total && r.textErrors.empty());
+    }
+    {
+        TaskEngine loaded;
+        loaded.setStorageFiles(files);
+        loaded.setLazyLoad(true);
+        start = Clock::now();
+        LoadReport r = loaded.load();
+        reportBulk("lazy snapshot:      ", total, msSince(start), r.fromSnapshot && loaded.count() == total);
+    }
+    fs::remove_all(dir, ec);
+    cout << "  peak RSS so far:    " << peakRssMiB() << " MiB\n";
+}
+
+// ================================
+// lists: one process hosting many lists (what todo --serve does, minus the sockets)
+// ================================
+void benchLists(int lists, int tasks, int open) {
+    namespace fs = std::filesystem;
+    cout << "lists " << lists << " lists of " << tasks << " tasks, at most " << open << " loaded\n";
+    fs::path dir = fs::temp_directory_path() / "bench_lists";
+    error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    {
+        TaskListCache cache(dir.string(), (size_t)open);
+        cache.setUndoLimits(100, 1u << 20);
+        vector<NewTask> batch(tasks, NewTask{ "hosted task", 3 });
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < lists; i++) cache.open("list" + to_string(i)).addTasks(batch.data(), batch.size());
+        cache.closeAll();
+        reportBulk("create and save all:", (size_t)lists * tasks, msSince(start), true);
+
+        // mostly the same few lists, now and then any of them, like users coming and going
+        XorShift rng(7);
+        Latencies hits, misses;
+        size_t before = cache.loads();
+        for (int i = 0; i < 20000; i++) {
+            int which = rng.next() % 10 < 8 ? (int)(rng.next() % (uint32_t)max(open / 2, 1)) : (int)(rng.next() % (uint32_t)lists);
+            string name = "list" + to_string(which);
+            size_t loads = cache.loads();
+            Latencies lat;
+            lat.time([&] {
+                HostedTaskEngine& list = cache.open(name);
+                list.setCompleted(list.front()->id, true);
+            });
+            (cache.loads() == loads ? hits : misses).ns.push_back(lat.ns[0]);
+        }
+        reportOps("use + done (hit):    ", hits);
+        reportOps("use + done (miss):   ", misses);
+        cout << "  loads: " << cache.loads() - before << ", evictions: " << cache.evictions()
+             << ", node slabs: " << TaskNodeArena::shared().slabCount() << "\n";
+    }
+    fs::remove_all(dir, ec);
+    cout << "  peak RSS so far:    " << peakRssMiB() << " MiB\n";
+}
+
+// ================================
+// gen: random batch file for the programs themselves
+// ================================
+void genWorkload(size_t commands, const string& path) {
+    FILE* out = (path == "-") ? stdout : fopen(path.c_str(), "wb");
+    if (!out) {
+        cout << "✗ Unable to create " << path << "\n";
+        exit(1);
+    }
+    static const char* words[] = { "buy", "call", "email", "fix", "review", "write", "plan", "clean", "milk", "report" };
+    XorShift rng(23);
+    int added = 0;
+    auto word = [&] { return words[rng.next() % 10]; };
+    auto someId = [&] { return added ? (int)(rng.next() % (uint32_t)added) + 1 : 1; };
+    for (size_t i = 0; i < commands; i++) {
+        uint32_t r = rng.next() % 100;
+        // the first fifth only adds, so the rest has tasks to work on
+        if (r < 40 || i < commands / 5) {
+            fprintf(out, "add %u \"%s %s %d\"\n", rng.next() % 5 + 1, word(), word(), ++added);
+        }
+        else if (r < 65) fprintf(out, "done %d\n", someId());
+        else if (r < 72) fprintf(out, "undone %d\n", someId());
+        else if (r < 82) fprintf(out, "del %d\n", someId());
+        else if (r < 88) fprintf(out, "undo\n");
+        else if (r < 90) fprintf(out, "redo\n");
+        else if (r < 97) fprintf(out, "edit %d %u \"%s %s\"\n", someId(), rng.next() % 6, word(), word());
+        else fprintf(out, "clear\n");
+    }
+    if (out != stdout) fclose(out);
+}
+
+// ================================
+// Main
+// ================================
+void usage() {
+    cout << "usage: bench parse [lines]\n";
+    cout << "       bench stress [tasks] [ops per thread]\n";
+    cout << "       bench scan [tasks]\n";
+    cout << "       bench search [tasks]\n";
+    cout << "       bench map [tasks...]\n";
+    cout << "       bench engine [tasks]\n";
+    cout << "       bench variants [tasks]\n";
+    cout << "       bench workload [tasks...] [--ops=N]\n";
+    cout << "       bench lists [lists] [tasks per list] [--open=N]\n";
+    cout << "       bench gen <commands> [file|-]\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    string what = argv[1];
+    if (what == "parse") {
+        size_t lines = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+        benchParse(lines);
+    }
+    else if (what == "stress") {
+        int tasks = argc > 2 ? atoi(argv[2]) : 100000;
+        int ops = argc > 3 ? atoi(argv[3]) : 200000;
+        benchStress(max(tasks, 1), max(ops, 1));
+    }
+    else if (what == "scan") {
+        int tasks = argc > 2 ? atoi(argv[2]) : 5000000;
+        benchScan(max(tasks, 1));
+    }
+    else if (what == "search") {
+        int tasks = argc > 2 ? atoi(argv[2]) : 1000000;
+        benchSearch(max(tasks, 1));
+    }
+    else if (what == "map") {
+        vector<int> sizes = { 10000, 1000000, 10000000 };
+        if (argc > 2) sizes.clear();
+        for (int i = 2; i < argc; i++) sizes.push_back(max(atoi(argv[i]), 1));
+        for (int tasks : sizes) benchMap(tasks);
+    }
+    else if (what == "engine") {
+        int tasks = argc > 2 ? atoi(argv[2]) : 1000000;
+        benchEngine<TaskEngine>("engine", max(tasks, 1));
+    }
+    else if (what == "variants") {
+        int tasks = argc > 2 ? atoi(argv[2]) : 1000000;
+        benchVariants(max(tasks, 1));
+    }
+    else if (what == "workload") {
+        vector<int> sizes;
+        int ops = 0;    // 0 = as many as tasks, at most 200k
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("--ops=", 0) == 0) ops = max(atoi(arg.c_str() + 6), 1);
+            else sizes.push_back(max(atoi(argv[i]), 1));
+        }
+        if (sizes.empty()) sizes = { 1000, 100000, 1000000 };
+        for (int tasks : sizes) benchWorkload(tasks, ops ? ops : min(tasks, 200000));
+    }
+    else if (what == "lists") {
+        vector<int> counts;
+        int open = 64;
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("--open=", 0) == 0) open = max(atoi(arg.c_str() + 7), 1);
+            else counts.push_back(max(atoi(argv[i]), 1));
+        }
+        benchLists(counts.size() > 0 ? counts[0] : 2000, counts.size() > 1 ? counts[1] : 100, open);
+    }
+    else if (what == "gen" && argc > 2) {
+        genWorkload(strtoull(argv[2], nullptr, 10), argc > 3 ? argv[3] : "-");
+    }
+    else {
+        usage();
+        return 1;
+    }
+    return 0;
+}
@@ -1,163 +1,187 @@
 /*
  * 1. Linked List - For sequential storage and traversal of tasks
- * 2. Hash Table (unordered_map) - For O(1) lookup by task ID
+ * 2. Hash Table (FlatIdMap, task_idmap.h) - For O(1) lookup by task ID
+ * 3. TaskStore (task_store.h) - Task fields kept in contiguous arrays for fast scans
+ * 4. RowRenderer (task_render.h) - Listings formatted into one buffer, written in chunks
+ * 5. WorkerPool (task_parallel.h) - Big stores are filtered on several threads
+ * 6. UndoJournal (task_undo.h) - The last changes can be undone / redone (batch mode)
+ * 7. SlotRanks (task_page.h) - Per-block counts, so one page of a long list is found in O(log n)
+ *
+ * All of them are put together in TaskEngine (task_engine.h), shared with projecttt.cpp
  */
 
 #include <iostream>
 #include <string>
-#include <unordered_map>
 #include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "task_engine.h"
+#include "task_render.h"
+#include "task_batch.h"
 using namespace std;
 
-// Node class for the linked list
-class Node {
-public:
-    int taskId;
-    string description;
-    int priority;
-    bool completed;
-    Node* next;
-    
-    // Constructor
-    Node(int id, string desc, int prio) {
-        taskId = id;
-        description = desc;
-        priority = prio;
-        completed = false;
-        next = nullptr;
-    }
-};
-
-// To-Do List class using Linked List and Hash Table
+// To-Do List class: the tasks live in a TaskEngine (linked list + hash table +
+// TaskStore, task_engine.h); this class adds the messages and the listings
 class ToDoList {
 private:
-    Node* head;                           
-    unordered_map<int, Node*> hashTable;  
-    int taskCounter;                      
-    int size;                             
+    TaskEngine engine;
+    RenderFormat listFormat;              // --format=plain|tsv|json
+    bool quiet;                           // no per-operation messages (batch mode)
+    TaskPage cursor;                      // the page shown last, for next / previous
+    
+    // Row layout shared by the three listings
+    static const RowLayout& rowLayout() {
+        static const RowLayout layout = { "✓ ", "○ ", "[ID: ", 2, "] ", 40, " (Priority: ", ")" };
+        return layout;
+    }
     
 public:
     // Constructor
     ToDoList() {
-        head = nullptr;
-        taskCounter = 1;
-        size = 0;
+        listFormat = RenderFormat::Plain;
+        quiet = false;
     }
     
-    // Destructor to free memory
-    ~ToDoList() {
-        Node* current = head;
-        while (current != nullptr) {
-            Node* temp = current;
-            current = current->next;
-            delete temp;
-        }
+    void setListFormat(RenderFormat format) {
+        listFormat = format;
+    }
+    
+    void setQuiet(bool on) {
+        quiet = on;
     }
     
-    // Add a new task to the list
-    void addTask(string description, int priority = 1) {
+    // --threads=N for big scans, 0 = all cores
+    void setScanThreads(int threads) {
+        engine.setScanThreads(threads);
+    }
+    
+    int getSize() const {
+        return engine.count();
+    }
+    
+    // Add a new task to the list, returns its ID (0 if the description is empty)
+    int addTask(string_view description, int priority = 1) {
         if (description.empty()) {
-            cout << "\n✗ Task description cannot be empty!\n";
-            return;
+            if (!quiet) cout << "\n✗ Task description cannot be empty!\n";
+            return 0;
         }
         
         if (priority < 1 || priority > 5) {
-            cout << "\n✗ Priority must be between 1 and 5. Setting to 1.\n";
+            if (!quiet) cout << "\n✗ Priority must be between 1 and 5. Setting to 1.\n";
             priority = 1;
         }
         
-        int taskId = taskCounter;
-        Node* newNode = new Node(taskId, description, priority);
-        
-        // Add to hash table for O(1) lookup
-        hashTable[taskId] = newNode;
-        
-        // Add to linked list (at the end)
-        if (head == nullptr) {
-            head = newNode;
-        } else {
-            Node* current = head;
-            while (current->next != nullptr) {
-                current = current->next;
-            }
-            current->next = newNode;
+        // Appended to the linked list and the hash table - O(1)
+        int taskId = engine.add(description, priority);
+        if (!quiet) cout << "\n✓ Task added successfully with ID: " << taskId << "\n";
+        return taskId;
+    }
+    
+    // Change a task's description and/or priority (empty / outside 1-5 = keep),
+    // false if there is no such task
+    bool editTask(int taskId, string_view description, int priority) {
+        if (!engine.update(taskId, description, priority)) {
+            if (!quiet) cout << "\n✗ Task ID " << taskId << " not found!\n";
+            return false;
         }
-        
-        taskCounter++;
-        size++;
-        cout << "\n✓ Task added successfully with ID: " << taskId << "\n";
+        if (!quiet) cout << "\n✓ Task " << taskId << " updated successfully!\n";
+        return true;
     }
     
-    // Delete a task by ID
-    void deleteTask(int taskId) {
-        if (hashTable.find(taskId) == hashTable.end()) {
-            cout << "\n✗ Task ID " << taskId << " not found!\n";
-            return;
+    // Delete a task by ID, false if there is no such task
+    bool deleteTask(int taskId) {
+        // The hash table gives the node, which is unlinked in O(1)
+        if (!engine.remove(taskId)) {
+            if (!quiet) cout << "\n✗ Task ID " << taskId << " not found!\n";
+            return false;
         }
+        if (!quiet) cout << "\n✓ Task " << taskId << " deleted successfully!\n";
+        return true;
+    }
+    
+    // Delete every completed task, returns how many.
+    // The flags are scanned (in parallel on big stores) to find them first.
+    int deleteAllCompleted() {
+        int removed = engine.removeCompleted();
         
-        // Remove from linked list
-        if (head->taskId == taskId) {
-            Node* temp = head;
-            head = head->next;
-            delete temp;
+        if (quiet) {
+            return removed;
+        }
+        if (removed == 0) {
+            cout << "\n⚠ No completed tasks to clear!\n";
         } else {
-            Node* current = head;
-            while (current->next != nullptr && current->next->taskId != taskId) {
-                current = current->next;
-            }
-            if (current->next != nullptr) {
-                Node* temp = current->next;
-                current->next = current->next->next;
-                delete temp;
-            }
+            cout << "\n✓ " << removed << " completed task(s) cleared!\n";
         }
-        
-        // Remove from hash table
-        hashTable.erase(taskId);
-        size--;
-        cout << "\n✓ Task " << taskId << " deleted successfully!\n";
+        return removed;
     }
     
-    // Mark a task as completed using hash table lookup (O(1))
-    void markComplete(int taskId) {
-        if (hashTable.find(taskId) != hashTable.end()) {
-            if (hashTable[taskId]->completed) {
-                cout << "\n⚠ Task " << taskId << " is already marked as complete!\n";
+    // Revert / repeat the last change (a clear is one change), false if there is none
+    bool undoLastChange() {
+        BulkResult r = engine.undo();
+        if (!quiet) {
+            if (r.applied == 0) cout << "\n⚠ Nothing to undo!\n";
+            else cout << "\n↩ Last change undone (" << r.applied << " task(s)).\n";
+        }
+        return r.applied > 0;
+    }
+    
+    bool redoLastChange() {
+        BulkResult r = engine.redo();
+        if (!quiet) {
+            if (r.applied == 0) cout << "\n⚠ Nothing to redo!\n";
+            else cout << "\n↪ Last change redone (" << r.applied << " task(s)).\n";
+        }
+        return r.applied > 0;
+    }
+    
+    // Mark a task as completed using hash table lookup (O(1)), false if not found
+    bool markComplete(int taskId) {
+        const TaskNode* node = engine.find(taskId);
+        if (node) {
+            if (engine.tasks().isCompleted(node->slot)) {
+                if (!quiet) cout << "\n⚠ Task " << taskId << " is already marked as complete!\n";
             } else {
-                hashTable[taskId]->completed = true;
-                cout << "\n✓ Task " << taskId << " marked as complete!\n";
+                engine.setCompleted(taskId, true);
+                if (!quiet) cout << "\n✓ Task " << taskId << " marked as complete!\n";
             }
-        } else {
-            cout << "\n✗ Task ID " << taskId << " not found!\n";
+            return true;
         }
+        if (!quiet) cout << "\n✗ Task ID " << taskId << " not found!\n";
+        return false;
     }
     
-    // Mark a task as incomplete
-    void markIncomplete(int taskId) {
-        if (hashTable.find(taskId) != hashTable.end()) {
-            if (!hashTable[taskId]->completed) {
-                cout << "\n⚠ Task " << taskId << " is already marked as incomplete!\n";
+    // Mark a task as incomplete, false if not found
+    bool markIncomplete(int taskId) {
+        const TaskNode* node = engine.find(taskId);
+        if (node) {
+            if (!engine.tasks().isCompleted(node->slot)) {
+                if (!quiet) cout << "\n⚠ Task " << taskId << " is already marked as incomplete!\n";
             } else {
-                hashTable[taskId]->completed = false;
-                cout << "\n✓ Task " << taskId << " marked as incomplete!\n";
+                engine.setCompleted(taskId, false);
+                if (!quiet) cout << "\n✓ Task " << taskId << " marked as incomplete!\n";
             }
-        } else {
-            cout << "\n✗ Task ID " << taskId << " not found!\n";
+            return true;
         }
+        if (!quiet) cout << "\n✗ Task ID " << taskId << " not found!\n";
+        return false;
     }
     
     // Search for a task by ID using hash table - O(1) complexity
     void searchTask(int taskId) {
-        if (hashTable.find(taskId) != hashTable.end()) {
-            Node* node = hashTable[taskId];
-            string status = node->completed ? "✓ Completed" : "○ Pending";
+        const TaskNode* node = engine.find(taskId);
+        if (node) {
+            const TaskStore& store = engine.tasks();
+            int slot = node->slot;
+            string status = store.isCompleted(slot) ? "✓ Completed" : "○ Pending";
             
             cout << "\n" << string(60, '=') << "\n";
             cout << "TASK DETAILS\n";
             cout << string(60, '=') << "\n";
-            cout << "Task ID: " << node->taskId << "\n";
-            cout << "Description: " << node->description << "\n";
-            cout << "Priority: " << node->priority << "\n";
+            cout << "Task ID: " << taskId << "\n";
+            cout << "Description: " << store.description(slot) << "\n";
+            cout << "Priority: " << store.priority(slot) << "\n";
             cout << "Status: " << status << "\n";
             cout << string(60, '=') << "\n\n";
         } else {
@@ -165,100 +189,152 @@ public:
         }
     }
     
-    // Display all tasks by traversing the linked list
+    // Display all tasks by streaming the store's slots (same order as the list)
     void displayAll() {
-        if (head == nullptr) {
+        MetricTimer timer(engine.metrics(), OP_LIST);
+        timer.items((uint64_t)engine.count());
+        if (engine.count() == 0 && listFormat == RenderFormat::Plain) {
             cout << "\n📋 No tasks in the list! Add some tasks to get started.\n\n";
             return;
         }
         
-        cout << "\n" << string(70, '=') << "\n";
-        cout << setw(40) << "TO-DO LIST\n";
-        cout << string(70, '=') << "\n";
-        cout << "Total tasks: " << size << "\n\n";
+        const string rule(70, '=');
+        RowRenderer out(cout, listFormat, rowLayout());
+        out.plain("\n" + rule + "\n");
+        out.plain("TO-DO LIST\n", 40);
+        out.plain(rule + "\n");
+        out.plain("Total tasks: " + to_string(engine.count()) + "\n\n");
         
-        Node* current = head;
-        while (current != nullptr) {
-            string status = current->completed ? "✓" : "○";
-            cout << status << " [ID: " << setw(2) << current->taskId << "] " 
-                 << setw(40) << left << current->description 
-                 << " (Priority: " << current->priority << ")\n";
-            current = current->next;
+        const TaskStore& store = engine.tasks();
+        for (int s = 0; s < store.slotCount(); s++) {
+            if (!store.isLive(s)) continue;
+            out.row(store.ids[s], store.description(s), store.priority(s), store.isCompleted(s));
         }
-        cout << string(70, '=') << "\n\n";
+        out.plain(rule + "\n\n");
     }
     
     // Display only pending tasks
     void displayPending() {
-        cout << "\n" << string(70, '=') << "\n";
-        cout << setw(40) << "PENDING TASKS\n";
-        cout << string(70, '=') << "\n";
-        
-        Node* current = head;
-        bool found = false;
-        int count = 0;
+        MetricTimer timer(engine.metrics(), OP_LIST);
+        const string rule(70, '=');
+        RowRenderer out(cout, listFormat, rowLayout());
+        out.plain("\n" + rule + "\n");
+        out.plain("PENDING TASKS\n", 40);
+        out.plain(rule + "\n");
         
-        while (current != nullptr) {
-            if (!current->completed) {
-                cout << "○ [ID: " << setw(2) << current->taskId << "] " 
-                     << setw(40) << left << current->description 
-                     << " (Priority: " << current->priority << ")\n";
-                found = true;
-                count++;
-            }
-            current = current->next;
+        // Only the flags array is read to find them (in parallel on big stores)
+        const TaskStore& store = engine.tasks();
+        vector<int> slots = engine.filter([&](int s) {
+            return store.flags[s] == TaskStore::LIVE;
+        });
+        for (int s : slots) {
+            out.row(store.ids[s], store.description(s), store.priority(s), false);
         }
         
-        if (!found) {
-            cout << "🎉 No pending tasks! Great job!\n";
+        if (out.rows() == 0) {
+            out.plain("🎉 No pending tasks! Great job!\n");
         } else {
-            cout << "\nTotal pending tasks: " << count << "\n";
+            out.plain("\nTotal pending tasks: " + to_string(out.rows()) + "\n");
         }
-        cout << string(70, '=') << "\n\n";
+        out.plain(rule + "\n\n");
     }
     
     // Display only completed tasks
     void displayCompleted() {
-        cout << "\n" << string(70, '=') << "\n";
-        cout << setw(40) << "COMPLETED TASKS\n";
-        cout << string(70, '=') << "\n";
+        MetricTimer timer(engine.metrics(), OP_LIST);
+        const string rule(70, '=');
+        RowRenderer out(cout, listFormat, rowLayout());
+        out.plain("\n" + rule + "\n");
+        out.plain("COMPLETED TASKS\n", 40);
+        out.plain(rule + "\n");
         
-        Node* current = head;
-        bool found = false;
-        int count = 0;
+        const TaskStore& store = engine.tasks();
+        vector<int> slots = engine.filter([&](int s) {
+            return store.flags[s] == (TaskStore::LIVE | TaskStore::DONE);
+        });
+        for (int s : slots) {
+            out.row(store.ids[s], store.description(s), store.priority(s), true);
+        }
         
-        while (current != nullptr) {
-            if (current->completed) {
-                cout << "✓ [ID: " << setw(2) << current->taskId << "] " 
-                     << setw(40) << left << current->description 
-                     << " (Priority: " << current->priority << ")\n";
-                found = true;
-                count++;
-            }
-            current = current->next;
+        if (out.rows() == 0) {
+            out.plain("No completed tasks yet!\n");
+        } else {
+            out.plain("\nTotal completed tasks: " + to_string(out.rows()) + "\n");
         }
+        out.plain(rule + "\n\n");
+    }
+    
+    // Display one page of a view (page is 1-based); only the tasks on the page are read
+    void displayPage(PageView view, int priority, int page, int size) {
+        cursor = engine.page(view, (size_t)(page - 1), (size_t)size, priority);
+        printPage();
+    }
+    
+    // Move the current page on / back, from the tasks it shows; false at the end / start
+    bool displayNextPage() {
+        if (cursor.atEnd()) return false;
+        cursor = engine.nextPage(cursor);
+        printPage();
+        return true;
+    }
+    
+    bool displayPrevPage() {
+        if (cursor.atStart()) return false;
+        cursor = engine.prevPage(cursor);
+        printPage();
+        return true;
+    }
+    
+    // Print operation counters, latencies and gauges (task_metrics.h) as a
+    // table, Prometheus text or JSON; false for an unknown format
+    bool showMetrics(string_view format) {
+        if (format.empty() || format == "plain") {
+            writeStatsTable(cout, engine.metrics(), engine.gauges());
+        } else if (format == "prometheus") {
+            writePrometheus(cout, engine.metrics(), engine.gauges());
+        } else if (format == "json") {
+            writeMetricsJson(cout, engine.metrics(), engine.gauges());
+        } else {
+            return false;
+        }
+        return true;
+    }
+    
+private:
+    // the rows of 'cursor'
+    void printPage() {
+        const string rule(70, '=');
+        RowRenderer out(cout, listFormat, rowLayout());
+        out.plain("\n" + rule + "\n");
+        out.plain(viewTitle(cursor.view, cursor.priority) + " - page " + to_string(cursor.number()) + " of " +
+                  to_string(cursor.pages()) + "\n");
+        out.plain(rule + "\n");
         
-        if (!found) {
-            cout << "No completed tasks yet!\n";
+        const TaskStore& store = engine.tasks();
+        for (int s : cursor.slots) {
+            out.row(store.ids[s], store.description(s), store.priority(s), store.isCompleted(s));
+        }
+        if (cursor.slots.empty()) {
+            out.plain("No tasks on this page.\n");
         } else {
-            cout << "\nTotal completed tasks: " << count << "\n";
+            out.plain("\nTasks " + to_string(cursor.first + 1) + "-" + to_string(cursor.first + cursor.slots.size()) +
+                      " of " + to_string(cursor.total) + "\n");
         }
-        cout << string(70, '=') << "\n\n";
+        out.plain(rule + "\n\n");
     }
     
-    // Display statistics about tasks
+public:
+    // Display statistics about tasks - O(1), the store keeps the counts up to date
     void getStatistics() {
+        int size = engine.count();
         if (size == 0) {
             cout << "\n📊 No tasks to show statistics for!\n\n";
             return;
         }
         
-        int completed = 0;
-        Node* current = head;
-        while (current != nullptr) {
-            if (current->completed) completed++;
-            current = current->next;
-        }
+        const TaskStore& store = engine.tasks();
+        store.checkCounters();  // debug builds only
+        int completed = store.doneCount;
         
         int pending = size - completed;
         double completionRate = (size > 0) ? (completed * 100.0 / size) : 0.0;
@@ -271,6 +347,11 @@ public:
         cout << "Pending Tasks:     " << pending << "\n";
         cout << fixed << setprecision(1);
         cout << "Completion Rate:   " << completionRate << "%\n";
+        cout << string(60, '-') << "\n";
+        for (int p = 5; p >= 1; p--) {
+            cout << "Priority " << p << ":        " << store.prioLive[p]
+                 << " (" << store.prioDone[p] << " completed)\n";
+        }
         cout << string(60, '=') << "\n\n";
     }
 };
@@ -283,9 +364,109 @@ void printHeader() {
     cout << string(70, '=') << "\n";
 }
 
+// Run one batch command (see task_batch.h); returns why it failed, or nullptr
+const char* runBatchCommand(ToDoList& todo, const BatchCommand& cmd) {
+    switch (cmd.op) {
+        case BATCH_NONE:
+            return nullptr;
+        case BATCH_ADD:
+            if (cmd.priority < 1 || cmd.priority > 5) return "priority must be 1-5";
+            return todo.addTask(cmd.text, cmd.priority) ? nullptr : "description cannot be empty";
+        case BATCH_EDIT:
+            if (cmd.priority < 0 || cmd.priority > 5) return "priority must be 0-5";
+            return todo.editTask(cmd.id, cmd.text, cmd.priority) ? nullptr : "task not found";
+        case BATCH_DONE:
+            return todo.markComplete(cmd.id) ? nullptr : "task not found";
+        case BATCH_UNDONE:
+            return todo.markIncomplete(cmd.id) ? nullptr : "task not found";
+        case BATCH_DEL:
+            return todo.deleteTask(cmd.id) ? nullptr : "task not found";
+        case BATCH_UNDO:
+            return todo.undoLastChange() ? nullptr : "nothing to undo";
+        case BATCH_REDO:
+            return todo.redoLastChange() ? nullptr : "nothing to redo";
+        case BATCH_CLEAR:
+            todo.deleteAllCompleted();
+            return nullptr;
+        case BATCH_LIST:
+            todo.displayAll();
+            return nullptr;
+        case BATCH_STATS:
+            return todo.showMetrics(cmd.text) ? nullptr : "stats format must be plain, prometheus or json";
+        case BATCH_PAGE: {
+            PageView view;
+            int priority;
+            parseView(cmd.text, view, priority);
+            todo.displayPage(view, priority, cmd.page, cmd.pageSize);
+            return nullptr;
+        }
+        default:
+            return "not supported by this program";
+    }
+}
+
+// Batch mode: run commands from a file (or stdin with "-") without the menu,
+// then print one summary. Returns the exit code.
+int runBatch(ToDoList& todo, const string& path) {
+    FILE* in = (path == "-") ? stdin : fopen(path.c_str(), "rb");
+    if (in == nullptr) {
+        cout << "✗ Unable to open '" << path << "'.\n";
+        return 1;
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    todo.setQuiet(true);
+    BatchCommand cmd;
+    string scratch;
+    vector<ParseError> errors;  // first few only
+    size_t ran = 0, failed = 0;
+    forEachLine(in, [&](const char* b, const char* e, size_t lineNo) {
+        const char* reason = parseBatchLine(b, e, cmd, scratch);
+        if (reason == nullptr && cmd.op == BATCH_NONE) return;
+        if (reason == nullptr) reason = runBatchCommand(todo, cmd);
+        ran++;
+        if (reason != nullptr) {
+            failed++;
+            if (errors.size() < 10) errors.push_back(ParseError{ lineNo, reason });
+        }
+    });
+    if (in != stdin) fclose(in);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    for (const ParseError& e : errors) {
+        cout << "⚠ line " << e.line << ": " << e.reason << "\n";
+    }
+    if (failed > errors.size()) {
+        cout << "⚠ ... and " << failed - errors.size() << " more failed command(s).\n";
+    }
+    cout << (failed ? "⚠ " : "✓ ") << ran << " command(s) run, " << failed << " failed, in "
+         << (long long)ms << " ms. " << todo.getSize() << " task(s) now.\n";
+    return failed ? 2 : 0;
+}
+
 // Main function
-int main() {
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);  // listings go out in large chunks (task_render.h)
     ToDoList todo;
+    bool batch = false;
+    string batchPath = "-";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        RenderFormat format;
+        if (arg == "--batch") {
+            batch = true;
+            if (i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0) batchPath = argv[++i];
+        } else if (parseFormatFlag(arg, format)) {
+            todo.setListFormat(format);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            todo.setScanThreads(atoi(arg.c_str() + 10));
+        } else {
+            cout << "usage: " << argv[0] << " [--format=plain|tsv|json] [--threads=N] [--batch [file|-]]\n";
+            return 1;
+        }
+    }
+    if (batch) {
+        return runBatch(todo, batchPath);  // starts empty, no sample tasks
+    }
     
     printHeader();
     
@@ -311,11 +492,20 @@ int main() {
         cout << "7.  Display Pending Tasks\n";
         cout << "8.  Display Completed Tasks\n";
         cout << "9.  Show Statistics\n";
-        cout << "10. Exit\n";
+        cout << "10. Clear Completed Tasks\n";
+        cout << "11. Exit\n";
+        cout << "12. Browse Tasks Page by Page\n";
         cout << string(70, '-') << "\n";
         
-        cout << "\n👉 Enter your choice (1-10): ";
-        cin >> choice;
+        cout << "\n👉 Enter your choice (1-12): ";
+        if (!(cin >> choice)) {
+            if (cin.eof()) break; // input closed (e.g. piped commands ran out)
+            cin.clear();
+            string dummy;
+            getline(cin, dummy);
+            cout << "\n✗ Invalid choice! Please enter a number between 1-12.\n";
+            continue;
+        }
         cin.ignore(); // Clear input buffer
         
         switch (choice) {
@@ -374,14 +564,51 @@ int main() {
                 break;
                 
             case 10:
+                todo.deleteAllCompleted();
+                break;
+                
+            case 11:
                 cout << "\n" << string(70, '=') << "\n";
                 cout << setw(42) << "Thank you for using To-Do List! 👋\n";
                 cout << setw(43) << "Stay productive and organized! 📝\n";
                 cout << string(70, '=') << "\n\n";
                 return 0;
                 
+            case 12: {
+                cout << "\n--- BROWSE TASKS ---\n";
+                cout << "View (all, pending, completed, priority, p1..p5): ";
+                string word;
+                getline(cin, word);
+                PageView view;
+                int viewPriority;
+                if (!parseView(word, view, viewPriority)) {
+                    cout << "\n✗ Unknown view!\n";
+                    break;
+                }
+                cout << "Tasks per page (default 20): ";
+                string sizeInput;
+                getline(cin, sizeInput);
+                int size = atoi(sizeInput.c_str());
+                todo.displayPage(view, viewPriority, 1, size > 0 ? size : 20);
+                while (true) {
+                    cout << "[n]ext, [p]revious, page number, [q]uit: ";
+                    string move;
+                    if (!getline(cin, move) || move.empty() || move == "q") break;
+                    if (move == "n") {
+                        if (!todo.displayNextPage()) cout << "\n⚠ Already on the last page!\n";
+                    } else if (move == "p") {
+                        if (!todo.displayPrevPage()) cout << "\n⚠ Already on the first page!\n";
+                    } else if (atoi(move.c_str()) >= 1) {
+                        todo.displayPage(view, viewPriority, atoi(move.c_str()), size > 0 ? size : 20);
+                    } else {
+                        cout << "\n✗ Invalid input!\n";
+                    }
+                }
+                break;
+            }
+                
             default:
-                cout << "\n✗ Invalid choice! Please enter a number between 1-10.\n";
+                cout << "\n✗ Invalid choice! Please enter a number between 1-12.\n";
         }
     }
     
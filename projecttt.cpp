@@ -1,104 +1,52 @@
 ﻿#include <iostream>
 #include <fstream>
-#include <unordered_map>
-#include <stack>
 #include <string>
 #include <iomanip>
-#include <algorithm> // for max
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include "task_engine.h"
+#include "task_render.h"
+#include "task_batch.h"
+#include "task_server.h"
 using namespace std;
 
 // ================================
-// Node for linked list (task)
+// The tasks themselves live in a TaskEngine (task_engine.h), which does no
+// console I/O; everything in this file is the menu and the printing
 // ================================
-struct Node {
-    int id;
-    string description;
-    int priority;   // 1..5
-    bool completed;
-    Node* next;
-};
 
-// ================================
-// Container for all program data
-// (avoids global variables)
-// ================================
-struct ToDoData {
-    Node* head;
-    unordered_map<int, Node*> taskMap;
-    stack<Node*> deletedStack; // stores copies of deleted tasks for undo
-    int nextId;
-    int totalTasks;
-
-    ToDoData() : head(nullptr), nextId(1), totalTasks(0) {}
-};
-
-// ================================
-// Utility: free all nodes in linked list
-// and clear map and stack (to avoid memory leak)
-// ================================
-void freeAll(ToDoData& data) {
-    Node* cur = data.head;
-    while (cur) {
-        Node* tmp = cur;
-        cur = cur->next;
-        delete tmp;
-    }
-    data.head = nullptr;
-    data.taskMap.clear();
-
-    // clear stack nodes
-    while (!data.deletedStack.empty()) {
-        delete data.deletedStack.top();
-        data.deletedStack.pop();
-    }
-    data.totalTasks = 0;
-}
+// how listings are written, set with --format=plain|tsv|json (see task_render.h)
+RenderFormat listFormat = RenderFormat::Plain;
 
 // ================================
 // Add a new task (to end of linked list)
 // ================================
-void addTask(ToDoData& data, const string& desc, int priority = 1) {
-    if (desc.empty()) {
+void addTask(TaskEngine& data, const string& desc, int priority = 1) {
+    int id = data.add(desc, priority);
+    if (id == 0) {
         cout << "✗ Description cannot be empty!\n";
         return;
     }
-    int pr = priority;
-    if (pr < 1 || pr > 5) pr = 1;
-
-    Node* newNode = new Node{ data.nextId, desc, pr, false, nullptr };
-
-    if (data.head == nullptr) {
-        data.head = newNode;
-    }
-    else {
-        Node* cur = data.head;
-        while (cur->next) cur = cur->next;
-        cur->next = newNode;
-    }
-
-    data.taskMap[data.nextId] = newNode;
-    cout << "✓ Task added with ID: " << data.nextId << "\n";
-    data.nextId++;
-    data.totalTasks++;
+    cout << "✓ Task added with ID: " << id << "\n";
 }
 
 // ================================
 // Edit a task by ID (description & priority)
 // ================================
-void editTask(ToDoData& data, int id) {
-    auto it = data.taskMap.find(id);
-    if (it == data.taskMap.end()) {
+void editTask(TaskEngine& data, int id) {
+    const TaskNode* t = data.find(id);
+    if (!t) {
         cout << "✗ Task not found!\n";
         return;
     }
-    Node* t = it->second;
-    cout << "Current description: " << t->description << "\n";
+    cout << "Current description: " << data.tasks().description(t->slot) << "\n";
     cout << "Enter new description (leave empty to keep): ";
     string newDesc;
     getline(cin, newDesc);
-    if (!newDesc.empty()) t->description = newDesc;
 
-    cout << "Current priority: " << t->priority << "\n";
+    cout << "Current priority: " << data.tasks().priority(t->slot) << "\n";
     cout << "Enter new priority (1-5, 0 to keep): ";
     int newPrio;
     if (!(cin >> newPrio)) { // handle non-int input
@@ -106,251 +54,490 @@ void editTask(ToDoData& data, int id) {
         string dummy;
         getline(cin, dummy);
         cout << "Invalid input. Priority unchanged.\n";
+        newPrio = 0;
     }
     else {
         cin.ignore(); // remove newline
-        if (newPrio >= 1 && newPrio <= 5) t->priority = newPrio;
-        else if (newPrio != 0) cout << "Invalid priority. Keeping old value.\n";
+        if (newPrio != 0 && (newPrio < 1 || newPrio > 5)) cout << "Invalid priority. Keeping old value.\n";
     }
 
+    data.update(id, newDesc, newPrio);
     cout << "✓ Task " << id << " updated.\n";
 }
 
 // ================================
-// Delete task by ID (push a copy to stack for undo)
+// Delete task by ID (its fields are kept for undo)
 // ================================
-void deleteTask(ToDoData& data, int id) {
-    auto it = data.taskMap.find(id);
-    if (it == data.taskMap.end()) {
+void deleteTask(TaskEngine& data, int id) {
+    if (!data.remove(id)) {
         cout << "✗ Task not found!\n";
         return;
     }
-
-    Node* cur = data.head;
-    Node* prev = nullptr;
-    while (cur && cur->id != id) {
-        prev = cur;
-        cur = cur->next;
-    }
-    if (!cur) return; // safety
-
-    // detach from list
-    if (!prev) data.head = cur->next;
-    else prev->next = cur->next;
-
-    // push a copy to deletedStack (so we can restore later)
-    Node* copyNode = new Node{ cur->id, cur->description, cur->priority, cur->completed, nullptr };
-    data.deletedStack.push(copyNode);
-
-    // remove from map and free node
-    data.taskMap.erase(id);
-    delete cur;
-    data.totalTasks--;
-
     cout << "✓ Task deleted (you can undo it).\n";
 }
 
 // ================================
-// Undo last delete (restore node to head)
+// Undo / redo the last change (deleted tasks come back where they were)
 // ================================
-void undoDelete(ToDoData& data) {
-    if (data.deletedStack.empty()) {
-        cout << "⚠ No deleted task to undo.\n";
+void undoChange(TaskEngine& data) {
+    BulkResult r = data.undo();
+    if (r.applied == 0) {
+        cout << "⚠ Nothing to undo.\n";
         return;
     }
-    Node* restored = data.deletedStack.top();
-    data.deletedStack.pop();
-
-    // insert at head for simplicity
-    restored->next = data.head;
-    data.head = restored;
-
-    data.taskMap[restored->id] = restored;
-    data.totalTasks++;
-    // ensure nextId stays greater than any id
-    data.nextId = max(data.nextId, restored->id + 1);
+    if (r.applied == 1) cout << "↩ Task " << r.firstId << " restored.\n";
+    else cout << "↩ " << r.applied << " tasks restored.\n";
+}
 
-    cout << "↩ Task " << restored->id << " restored.\n";
+void redoChange(TaskEngine& data) {
+    BulkResult r = data.redo();
+    if (r.applied == 0) {
+        cout << "⚠ Nothing to redo.\n";
+        return;
+    }
+    if (r.applied == 1) cout << "↪ Change to task " << r.firstId << " redone.\n";
+    else cout << "↪ Change to " << r.applied << " tasks redone.\n";
 }
 
 // ================================
 // Search task by ID and print details
 // ================================
-void searchTask(ToDoData& data, int id) {
-    auto it = data.taskMap.find(id);
-    if (it == data.taskMap.end()) {
+void searchTask(TaskEngine& data, int id) {
+    const TaskNode* t = data.find(id);
+    if (!t) {
         cout << "✗ Task not found!\n";
         return;
     }
-    Node* t = it->second;
     cout << "\n--- Task Found ---\n";
     cout << "ID: " << t->id << "\n";
-    cout << "Description: " << t->description << "\n";
-    cout << "Priority: " << t->priority << "\n";
-    cout << "Status: " << (t->completed ? "Done" : "Pending") << "\n";
+    const TaskStore& st = data.tasks();
+    cout << "Description: " << st.description(t->slot) << "\n";
+    cout << "Priority: " << st.priority(t->slot) << "\n";
+    cout << "Status: " << (st.isCompleted(t->slot) ? "Done" : "Pending") << "\n";
+    if (int64_t when = st.deadline(t->slot)) {
+        char date[32];
+        cout << "Deadline: " << formatDeadline(when, date, sizeof(date)) << "\n";
+    }
     cout << "------------------\n";
 }
 
+// ================================
+// Deadlines and the "what next" queue (task_schedule.h): the next task is the
+// pending one with the lowest priority number, then the earliest deadline
+// ================================
+void setTaskDeadline(TaskEngine& data, int id, const string& text) {
+    int64_t when;
+    if (!parseDeadline(text, when)) {
+        cout << "✗ Enter a date as YYYY-MM-DD, or none.\n";
+        return;
+    }
+    if (!data.setDeadline(id, when)) {
+        cout << "✗ Task not found!\n";
+        return;
+    }
+    if (when) cout << "✓ Task " << id << " is due " << text << ".\n";
+    else cout << "✓ Task " << id << " has no deadline now.\n";
+}
+
+void showNextTask(TaskEngine& data) {
+    int id = data.peekNext();
+    if (id == 0) {
+        cout << "📋 No pending tasks.\n";
+        return;
+    }
+    searchTask(data, id);
+}
+
+// batch `next`: with --format=tsv|json the task is one row like any listing
+// (none: no rows); plain text gets the block above, which shows the deadline
+void renderNextTask(TaskEngine& data) {
+    if (listFormat == RenderFormat::Plain) {
+        showNextTask(data);
+        return;
+    }
+    static const RowLayout layout = { "✓ ", "○ ", "[ID:", 0, "] ", 30, " (P:", ")" };
+    RowRenderer out(cout, listFormat, layout);
+    if (int id = data.peekNext()) {
+        const TaskStore& st = data.tasks();
+        int s = data.find(id)->slot;
+        out.row(id, st.description(s), st.priority(s), st.isCompleted(s));
+    }
+}
+
+void takeNextTask(TaskEngine& data) {
+    int id = data.popNext();
+    if (id == 0) {
+        cout << "📋 No pending tasks.\n";
+        return;
+    }
+    const TaskNode* t = data.find(id);
+    cout << "✓ Task " << id << " (" << data.tasks().description(t->slot) << ") completed.\n";
+}
+
 // ================================
 // Mark complete / incomplete
 // ================================
-void markComplete(ToDoData& data, int id, bool done) {
-    auto it = data.taskMap.find(id);
-    if (it == data.taskMap.end()) {
+void markComplete(TaskEngine& data, int id, bool done) {
+    if (!data.setCompleted(id, done)) {
         cout << "✗ Task not found!\n";
         return;
     }
-    it->second->completed = done;
     cout << "✓ Task " << id << (done ? " completed.\n" : " marked incomplete.\n");
 }
 
 // ================================
 // Print all tasks (traverse linked list)
 // ================================
-void printAll(ToDoData& data) {
-    if (!data.head) {
+void printAll(TaskEngine& data) {
+    MetricTimer timer(data.metrics(), OP_LIST);
+    timer.items((uint64_t)data.count());
+    if (data.count() == 0 && listFormat == RenderFormat::Plain) {
         cout << "📋 No tasks available.\n";
         return;
     }
-    cout << "\n" << string(60, '=') << "\n";
-    cout << setw(35) << "TO-DO LIST\n";
-    cout << string(60, '=') << "\n";
-    Node* cur = data.head;
-    while (cur) {
-        cout << (cur->completed ? "✓ " : "○ ")
-            << "[ID:" << cur->id << "] "
-            << left << setw(30) << cur->description
-            << " (P:" << cur->priority << ")\n";
-        cur = cur->next;
-    }
-    cout << string(60, '=') << "\n";
+    static const RowLayout layout = { "✓ ", "○ ", "[ID:", 0, "] ", 30, " (P:", ")" };
+    const string rule(60, '=');
+    RowRenderer out(cout, listFormat, layout);
+    out.plain("\n" + rule + "\n");
+    out.plain("TO-DO LIST\n", 35);
+    out.plain(rule + "\n");
+    const TaskStore& st = data.tasks();
+    for (const TaskNode* cur = data.front(); cur; cur = cur->next) {
+        out.row(cur->id, st.description(cur->slot), st.priority(cur->slot), st.isCompleted(cur->slot));
+    }
+    out.plain(rule + "\n");
 }
 
 // ================================
 // Save tasks to file (tasks.txt)
 // format per line: id|description|priority|completed
+// written from a copy on a background thread, so the menu carries on meanwhile
+// ================================
+void saveToFile(TaskEngine& data, const string& filename = "tasks.txt") {
+    data.exportTextInBackground(filename);
+    cout << "✓ Saving tasks to '" << filename << "' in the background.\n";
+}
+
+// say which background saves failed since the last call
+void reportFailedSaves(TaskEngine& data) {
+    for (const string& path : data.failedSaves()) cout << "✗ Unable to write '" << path << "'.\n";
+}
+
 // ================================
-void saveToFile(ToDoData& data, const string& filename = "tasks.txt") {
-    ofstream fout(filename);
-    if (!fout.is_open()) {
-        cout << "✗ Unable to open file for saving.\n";
+// Save tasks as a binary snapshot (tasks.bin), see task_snapshot.h
+// ================================
+void saveSnapshot(TaskEngine& data) {
+    if (!data.checkpoint()) {
+        cout << "✗ Unable to write snapshot '" << data.storageFiles().snapshot << "'.\n";
+        return;
+    }
+    cout << "✓ Tasks saved to '" << data.storageFiles().snapshot << "'.\n";
+}
+
+// ================================
+// Startup: load tasks.bin / tasks.txt and replay tasks.log (TaskEngine::load)
+// and say what happened; malformed tasks.txt lines are reported with their line number
+// ================================
+void loadTasks(TaskEngine& data) {
+    const StorageFiles& files = data.storageFiles();
+    LoadReport r = data.load();
+    if (r.invalidSnapshot) cout << "⚠ '" << files.snapshot << "' is not a valid snapshot, reading '" << files.text << "' instead.\n";
+
+    const size_t shown = 10;
+    for (size_t i = 0; i < r.textErrors.size() && i < shown; i++) {
+        cout << "⚠ " << files.text << " line " << r.textErrors[i].line << ": " << r.textErrors[i].reason << " (skipped)\n";
+    }
+    if (r.textErrors.size() > shown) {
+        cout << "⚠ ... and " << r.textErrors.size() - shown << " more malformed line(s) skipped.\n";
+    }
+
+    if (r.droppedLog) cout << "⚠ '" << files.text << "' replaced the saved tasks; unsaved changes in '" << files.log << "' were dropped.\n";
+    if (!r.logOpen) {
+        cout << "⚠ Unable to open '" << files.log << "'; changes are only saved on exit.\n";
         return;
     }
-    Node* cur = data.head;
-    while (cur) {
-        // Replace any '|' in description to avoid parse issues (simple sanitize)
-        string desc = cur->description;
-        size_t pos;
-        while ((pos = desc.find('|')) != string::npos) desc.replace(pos, 1, " "); // remove pipe
-        fout << cur->id << "|" << desc << "|" << cur->priority << "|" << (cur->completed ? 1 : 0) << "\n";
-        cur = cur->next;
-    }
-    fout.close();
-    cout << "✓ Tasks saved to '" << filename << "'.\n";
+    // a lazy session keeps the log on purpose; only changes no clean exit followed were recovered
+    if (r.recovered > 0) cout << "↩ Recovered " << r.recovered << " unsaved change(s) from '" << files.log << "'.\n";
 }
 
 // ================================
-// Load tasks from file (tasks.txt)
-// expects same format used in saveToFile
+// Print tasks to a separate output file for submission (output.txt),
+// in the background like saveToFile
 // ================================
-void loadFromFile(ToDoData& data, const string& filename = "tasks.txt") {
-    ifstream fin(filename);
-    if (!fin.is_open()) {
-        // no file yet — not an error
+void printToOutputFile(TaskEngine& data, const string& filename = "output.txt") {
+    data.saveInBackground(filename, [](ostream& fout, const TaskStore& st, const vector<int>& slots) {
+        static const RowLayout layout = { "[✓] ", "[ ] ", "", 0, " - ", 0, " (P:", ")" };
+        RowRenderer out(fout, RenderFormat::Plain, layout);
+        for (int s : slots) out.row(st.ids[s], st.description(s), st.priority(s), st.isCompleted(s));
+    });
+    cout << "✓ Writing output to '" << filename << "' in the background.\n";
+}
+
+//========================
+// print task in order of priority.
+void printByPriority(TaskEngine& data) {
+    MetricTimer timer(data.metrics(), OP_LIST);
+    timer.items((uint64_t)data.count());
+    if (data.count() == 0 && listFormat == RenderFormat::Plain) {
+        cout << "no tasks available\n";
         return;
     }
+
+    // one walk per priority bucket, so every task is visited exactly once
+    static const RowLayout layout = { "[✓] ", "[ ] ", "[ID:", 0, "] ", 0, " (P:", ")" };
+    const TaskStore& st = data.tasks();
+    RowRenderer out(cout, listFormat, layout);
+    out.plain("\n=== Tasks Sorted by Priority ===\n");
+    for (int pr = 1; pr <= 5; pr++) {  // highest priority (1) is at first
+        for (int s = st.prioHead[pr]; s != -1; s = st.prioNext[s]) {
+            out.row(st.ids[s], st.description(s), pr, st.isCompleted(s));
+        }
+    }
+    out.plain("===============================\n");
+}
+
+//=======================
+// one page of a view (task_page.h); only the tasks on the page are looked at,
+// however long the list is
+void printPage(TaskEngine& data, const TaskPage& page) {
+    if (page.slots.empty() && listFormat == RenderFormat::Plain) {
+        cout << "📋 No tasks on page " << page.number() << " (" << page.total << " task(s), "
+             << page.pages() << " page(s)).\n";
+        return;
+    }
+    static const RowLayout layout = { "[✓] ", "[ ] ", "[ID:", 0, "] ", 0, " (P:", ")" };
+    const TaskStore& st = data.tasks();
+    RowRenderer out(cout, listFormat, layout);
+    out.plain("\n=== " + viewTitle(page.view, page.priority) + ": page " + to_string(page.number()) + " of " +
+              to_string(page.pages()) + " (" + to_string(page.first + 1) + "-" +
+              to_string(page.first + page.slots.size()) + " of " + to_string(page.total) + ") ===\n");
+    for (int s : page.slots) {
+        out.row(st.ids[s], st.description(s), st.priority(s), st.isCompleted(s));
+    }
+    out.plain("===============================\n");
+}
+
+// page through a view: n / p move on from the tasks shown, a number jumps to that page
+void browsePages(TaskEngine& data) {
+    cout << "View (all, pending, completed, priority, p1..p5): ";
+    string word;
+    getline(cin, word);
+    PageView view;
+    int prio;
+    if (!parseView(word, view, prio)) {
+        cout << "✗ Unknown view.\n";
+        return;
+    }
+    cout << "Tasks per page (default 20): ";
     string line;
-    while (getline(fin, line)) {
-        if (line.empty()) continue;
-        size_t p1 = line.find('|');
-        size_t p2 = line.find('|', p1 + 1);
-        size_t p3 = line.find('|', p2 + 1);
-        if (p1 == string::npos || p2 == string::npos || p3 == string::npos) continue; // malformed line
-
-        int id = stoi(line.substr(0, p1));
-        string desc = line.substr(p1 + 1, p2 - p1 - 1);
-        int prio = stoi(line.substr(p2 + 1, p3 - p2 - 1));
-        int done = stoi(line.substr(p3 + 1));
-
-        Node* n = new Node{ id, desc, prio, (done != 0), nullptr };
-        if (data.head == nullptr) data.head = n;
+    getline(cin, line);
+    int size = atoi(line.c_str());
+    if (size < 1) size = 20;
+
+    TaskPage page = data.page(view, 0, (size_t)size, prio);
+    bool show = true;
+    while (true) {
+        if (show) printPage(data, page);
+        show = true;
+        cout << "[n]ext, [p]rev, page number, [q]uit: ";
+        string cmd;
+        if (!getline(cin, cmd) || cmd.empty() || cmd == "q") break;
+        if (cmd == "n") {
+            if (page.atEnd()) { cout << "⚠ This is the last page.\n"; show = false; }
+            else page = data.nextPage(page);
+        }
+        else if (cmd == "p") {
+            if (page.atStart()) { cout << "⚠ This is the first page.\n"; show = false; }
+            else page = data.prevPage(page);
+        }
+        else if (atoi(cmd.c_str()) >= 1) {
+            page = data.page(view, (size_t)atoi(cmd.c_str()) - 1, (size_t)size, prio);
+        }
         else {
-            Node* cur = data.head;
-            while (cur->next) cur = cur->next;
-            cur->next = n;
+            cout << "Invalid input. Try again.\n";
+            show = false;
         }
-        data.taskMap[id] = n;
-        data.nextId = max(data.nextId, id + 1);
-        data.totalTasks++;
     }
-    fin.close();
 }
 
-// ================================
-// Print tasks to a separate output file for submission (output.txt)
-// ================================
-void printToOutputFile(ToDoData& data, const string& filename = "output.txt") {
-    ofstream fout(filename);
-    if (!fout.is_open()) {
-        cout << "✗ Unable to open output file.\n";
+//=======================
+// print the k most urgent pending tasks (priority 1 first)
+// only the buckets needed to find k tasks are looked at
+void printTopPending(TaskEngine& data, int k) {
+    MetricTimer timer(data.metrics(), OP_LIST);
+    static const int urgentFirst[5] = { 1, 2, 3, 4, 5 };
+    const TaskStore& st = data.tasks();
+    vector<int> slots = st.topPending(k, urgentFirst);
+    if (slots.empty() && listFormat == RenderFormat::Plain) {
+        cout << "No pending tasks.\n";
         return;
     }
-    Node* cur = data.head;
-    while (cur) {
-        fout << (cur->completed ? "[✓] " : "[ ] ")
-            << cur->id << " - " << cur->description
-            << " (P:" << cur->priority << ")\n";
-        cur = cur->next;
+    static const RowLayout layout = { "", "", "[ID:", 0, "] ", 0, " (P:", ")" };
+    RowRenderer out(cout, listFormat, layout);
+    out.plain("\n=== Top " + to_string(slots.size()) + " Pending Tasks ===\n");
+    for (int s : slots) {
+        out.row(st.ids[s], st.description(s), st.priority(s), false);
     }
-    fout.close();
-    cout << "✓ Output written to '" << filename << "'.\n";
+    out.plain("===============================\n");
 }
 
-//========================
-// print task in order of priority.
-void printByPriority(ToDoData& data) {
-    if (data.head == NULL) {
-        cout << "no tasks available\n";
+//=======================
+// find tasks by words in their description (see task_index.h for the query syntax)
+// the index is built on the first search and kept up to date from then on
+void searchByText(TaskEngine& data, string_view query) {
+    vector<int> ids = data.search(query);
+    const TaskStore& st = data.tasks();
+    if (ids.empty() && listFormat == RenderFormat::Plain) {
+        cout << "No tasks match \"" << query << "\".\n";
         return;
     }
+    static const RowLayout layout = { "[✓] ", "[ ] ", "[ID:", 0, "] ", 0, " (P:", ")" };
+    RowRenderer out(cout, listFormat, layout);
+    out.plain("\n=== " + to_string(ids.size()) + " Task(s) Matching \"" + string(query) + "\" ===\n");
+    for (int id : ids) {
+        int s = data.find(id)->slot;
+        out.row(id, st.description(s), st.priority(s), st.isCompleted(s));
+    }
+    out.plain("===============================\n");
+}
 
-    cout << "\n=== Tasks Sorted by Priority ===\n";
-    for (int pr = 1; pr <= 5; pr++) {  // highest priority (1) is at first
-        Node* cur = data.head;
-        while (cur != NULL) { // stops at last, when cur->next is actually null
-            if (cur->priority == pr) {
-                cout << (cur->completed ? "[✓] " : "[ ] ")
-                     << "[ID:" << cur->id << "] "
-                     << cur->description
-                     << " (P:" << cur->priority << ")\n";
-            }
-            cur = cur->next;
-        }
-    }
-    cout << "===============================\n";
+//=======================
+// statistics straight from the store's running counters (no list walk)
+void printStatistics(TaskEngine& data) {
+    const TaskStore& st = data.tasks();
+    st.checkCounters(); // debug builds only
+    if (st.liveCount == 0) {
+        cout << "No tasks available.\n";
+        return;
+    }
+    cout << "\n=== Task Statistics ===\n";
+    cout << "Total:     " << st.liveCount << "\n";
+    cout << "Completed: " << st.doneCount << "\n";
+    cout << "Pending:   " << st.liveCount - st.doneCount << "\n";
+    for (int pr = 1; pr <= 5; pr++) {
+        cout << "P" << pr << ": " << st.prioLive[pr] << " (" << st.prioDone[pr] << " done)\n";
+    }
+    cout << "=======================\n";
+}
+
+//=======================
+// operation counters, latencies and gauges (see task_metrics.h) as a table,
+// Prometheus text or JSON; returns why it failed, or nullptr
+const char* printMetrics(TaskEngine& data, string_view format) {
+    if (format.empty() || format == "plain") writeStatsTable(cout, data.metrics(), data.gauges());
+    else if (format == "prometheus") writePrometheus(cout, data.metrics(), data.gauges());
+    else if (format == "json") writeMetricsJson(cout, data.metrics(), data.gauges());
+    else return "stats format must be plain, prometheus or json";
+    return nullptr;
 }
 
 //=======================
 // clear any completed task.
-void deleteAllCompleted(ToDoData& data) {
-    if (data.head == NULL) {
+// one pass: each completed node is unlinked, saved for undo and erased on the spot
+void deleteAllCompleted(TaskEngine& data) {
+    if (data.count() == 0) {
         cout << "No tasks available.\n";
         return;
     }
 
-    Node* cur = data.head;
-
-    while (cur) {
-        Node* nextNode = cur->next;
+    int removed = data.removeCompleted();
+    if (removed == 0) {
+        cout << "No completed tasks to clear.\n";
+        return;
+    }
+    cout << "✓ " << removed << " completed task(s) cleared.\n";
+    if (data.canUndo()) cout << "  (undo brings them all back)\n";
+    else cout << "⚠ Too many to keep for undo (over the undo memory limit).\n";
+}
 
-        if (cur->completed) {
-            deleteTask(data, cur->id);
-        }
 
-        cur = nextNode;
+// ================================
+// Batch mode: run the commands in task_batch.h from a file (or stdin with "-")
+// with no menu output, save, and print one summary at the end
+// ================================
+const char* runBatchCommand(TaskEngine& data, const BatchCommand& cmd) {
+    switch (cmd.op) {
+    case BATCH_NONE:
+        return nullptr;
+    case BATCH_ADD:
+        if (cmd.priority < 1 || cmd.priority > 5) return "priority must be 1-5";
+        return data.add(cmd.text, cmd.priority) ? nullptr : "description cannot be empty";
+    case BATCH_EDIT:
+        if (cmd.priority < 0 || cmd.priority > 5) return "priority must be 0-5";
+        return data.update(cmd.id, cmd.text, cmd.priority) ? nullptr : "task not found";
+    case BATCH_DONE:
+    case BATCH_UNDONE:
+        return data.setCompleted(cmd.id, cmd.op == BATCH_DONE) ? nullptr : "task not found";
+    case BATCH_DEL:
+        return data.remove(cmd.id) ? nullptr : "task not found";
+    case BATCH_UNDO:
+        return data.undo().applied ? nullptr : "nothing to undo";
+    case BATCH_REDO:
+        return data.redo().applied ? nullptr : "nothing to redo";
+    case BATCH_CLEAR:
+        data.removeCompleted();
+        return nullptr;
+    case BATCH_LIST:
+        printAll(data);
+        return nullptr;
+    case BATCH_FIND:
+        searchByText(data, cmd.text);
+        return nullptr;
+    case BATCH_SAVE:
+        return data.checkpoint() ? nullptr : "unable to write tasks.bin";
+    case BATCH_STATS:
+        return printMetrics(data, cmd.text);
+    case BATCH_DUE:
+        return data.setDeadline(cmd.id, cmd.deadline) ? nullptr : "task not found";
+    case BATCH_NEXT:
+        renderNextTask(data);
+        return nullptr;
+    case BATCH_POP:
+        return data.popNext() ? nullptr : "no pending tasks";
+    case BATCH_PAGE: {
+        PageView view;
+        int prio;
+        parseView(cmd.text, view, prio);
+        printPage(data, data.page(view, (size_t)cmd.page - 1, (size_t)cmd.pageSize, prio));
+        return nullptr;
     }
+    }
+    return "unknown command";
 }
 
+// returns the exit code: 0 if every command ran, 2 if some failed, 1 if the file is missing
+int runBatch(TaskEngine& data, const string& path) {
+    FILE* in = (path == "-") ? stdin : fopen(path.c_str(), "rb");
+    if (!in) {
+        cout << "✗ Unable to open '" << path << "'.\n";
+        return 1;
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    BatchCommand cmd;
+    string scratch;
+    vector<ParseError> errors; // first few only
+    size_t ran = 0, failed = 0;
+    forEachLine(in, [&](const char* b, const char* e, size_t lineNo) {
+        const char* reason = parseBatchLine(b, e, cmd, scratch);
+        if (!reason && cmd.op == BATCH_NONE) return;
+        if (!reason) reason = runBatchCommand(data, cmd);
+        ran++;
+        if (reason) {
+            failed++;
+            if (errors.size() < 10) errors.push_back(ParseError{ lineNo, reason });
+        }
+    });
+    if (in != stdin) fclose(in);
+    bool saved = data.persist();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    for (const ParseError& e : errors) cout << "⚠ line " << e.line << ": " << e.reason << "\n";
+    if (failed > errors.size()) cout << "⚠ ... and " << failed - errors.size() << " more failed command(s).\n";
+    cout << (failed ? "⚠ " : "✓ ") << ran << " command(s) run, " << failed << " failed, in "
+         << (long long)ms << " ms. " << data.count() << " task(s) now.\n";
+    if (!saved) cout << "✗ Unable to write snapshot '" << data.storageFiles().snapshot << "'.\n";
+    return (failed || !saved) ? 2 : 0;
+}
 
 // ================================
 // Simple menu display
@@ -360,7 +547,7 @@ void showMenu() {
     cout << "1. Add Task\n";
     cout << "2. Edit Task\n";
     cout << "3. Delete Task\n";
-    cout << "4. Undo Delete (restore last deleted)\n";
+    cout << "4. Undo last change (edit, complete, delete or clear)\n";
     cout << "5. Mark Complete\n";
     cout << "6. Mark Incomplete\n";
     cout << "7. Search Task by ID\n";
@@ -368,6 +555,16 @@ void showMenu() {
     cout << "9. Show tasks in order of priority\n";
     cout << "10. clear completed tasks\n";
     cout << "11. Save & Exit (also write output.txt)\n";
+    cout << "12. Show statistics\n";
+    cout << "13. Show top pending tasks\n";
+    cout << "14. Export tasks to tasks.txt (text format)\n";
+    cout << "15. Search tasks by text\n";
+    cout << "16. Redo (what undo reverted)\n";
+    cout << "17. Show performance stats\n";
+    cout << "18. Set a task's deadline\n";
+    cout << "19. Show the next task to do\n";
+    cout << "20. Complete the next task\n";
+    cout << "21. Browse tasks page by page\n";
     cout << "====================================\n";
     cout << "Choose: ";
 }
@@ -375,19 +572,92 @@ void showMenu() {
 // ================================
 // Main program
 // ================================
-int main() {
-    ToDoData data;
-    // Load from file at start
-    loadFromFile(data, "tasks.txt");
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false); // listings are written in large chunks, see task_render.h
+    bool batch = false;
+    string batchPath = "-";
+    size_t undoSteps = UndoJournal::DEFAULT_STEPS;
+    size_t undoBytes = UndoJournal::DEFAULT_BUDGET;
+    bool lazy = false;
+    int autosave = 0;
+    int servePort = 0;
+    string listsDir = "lists";
+    size_t maxLists = 256;      // each loaded list keeps its tasks.log open
+    bool bindAll = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--batch") {
+            batch = true;
+            if (i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0) batchPath = argv[++i];
+        }
+        else if (arg.rfind("--undo-steps=", 0) == 0) {
+            undoSteps = strtoull(arg.c_str() + 13, nullptr, 10);
+        }
+        else if (arg.rfind("--undo-memory=", 0) == 0) {
+            undoBytes = (size_t)strtoull(arg.c_str() + 14, nullptr, 10) << 20;
+        }
+        else if (arg == "--lazy") {
+            lazy = true;    // descriptions are read from the files when first used
+        }
+        else if (arg.rfind("--autosave=", 0) == 0) {
+            autosave = atoi(arg.c_str() + 11);  // seconds between background exports of tasks.txt
+        }
+        else if (arg.rfind("--serve=", 0) == 0) {
+            servePort = atoi(arg.c_str() + 8);  // serve many lists over TCP instead, see task_server.h
+        }
+        else if (arg.rfind("--lists=", 0) == 0) {
+            listsDir = arg.substr(8);
+        }
+        else if (arg.rfind("--max-lists=", 0) == 0) {
+            maxLists = strtoull(arg.c_str() + 12, nullptr, 10);
+        }
+        else if (arg == "--public") {
+            bindAll = true;     // listen on every interface, not just 127.0.0.1
+        }
+        else if (!parseFormatFlag(arg, listFormat)) {
+            cout << "usage: " << argv[0] << " [--format=plain|tsv|json] [--batch [file|-]]"
+                 << " [--undo-steps=N] [--undo-memory=MiB] [--lazy] [--autosave=SECONDS]\n"
+                 << "       " << argv[0] << " --serve=PORT [--lists=DIR] [--max-lists=N] [--public]"
+                 << " [--undo-steps=N] [--undo-memory=MiB] [--lazy]\n";
+            return 1;
+        }
+    }
+
+    if (servePort > 0) {
+        error_code ec;
+        filesystem::create_directories(listsDir, ec);
+        TaskListCache lists(listsDir, maxLists);
+        lists.setUndoLimits(undoSteps, undoBytes);
+        lists.setLazyLoad(lazy);
+        TaskServer server(lists);
+        return server.run(servePort, bindAll, cout);
+    }
+
+    TaskEngine data;
+    data.setUndoLimits(undoSteps, undoBytes);
+    data.setLazyLoad(lazy);
+    data.setAutosave(chrono::seconds(autosave > 0 ? autosave : 0));
+    // Load from tasks.bin (or tasks.txt) at start
+    loadTasks(data);
+
+    if (batch) {
+        int status = runBatch(data, batchPath);
+        data.flushSaves();
+        reportFailedSaves(data);
+        data.close();
+        return status;
+    }
 
     // Example: if you want to add sample tasks uncomment below:
     // addTask(data, "Sample task 1", 3);
     // addTask(data, "Sample task 2", 2);
 
     while (true) {
+        reportFailedSaves(data);    // from the background saves started so far
         showMenu();
         int choice;
         if (!(cin >> choice)) {
+            if (cin.eof()) break; // input closed; tasks.log already has every change
             cin.clear();
             string dummy;
             getline(cin, dummy);
@@ -417,7 +687,7 @@ int main() {
             deleteTask(data, id);
         }
         else if (choice == 4) {
-            undoDelete(data);
+            undoChange(data);
         }
         else if (choice == 5) {
             cout << "Enter Task ID to mark complete: ";
@@ -445,18 +715,64 @@ int main() {
         }    
             
         else if (choice == 11) {
-            saveToFile(data, "tasks.txt");
+            saveSnapshot(data);
             printToOutputFile(data, "output.txt");
+            data.flushSaves();      // output.txt (and any save still running) is on disk before we go
+            reportFailedSaves(data);
             cout << "Goodbye!\n";
             break;
         }
+        else if (choice == 12) {
+            printStatistics(data);
+        }
+        else if (choice == 13) {
+            cout << "How many tasks: ";
+            int k;
+            if (!(cin >> k)) { cin.clear(); string d; getline(cin, d); k = 5; }
+            cin.ignore();
+            printTopPending(data, k);
+        }
+        else if (choice == 14) {
+            saveToFile(data, data.storageFiles().text);
+        }
+        else if (choice == 15) {
+            cout << "Search words (word* for a prefix): ";
+            string query;
+            getline(cin, query);
+            searchByText(data, query);
+        }
+        else if (choice == 16) {
+            redoChange(data);
+        }
+        else if (choice == 17) {
+            printMetrics(data, "plain");
+        }
+        else if (choice == 18) {
+            cout << "Enter Task ID: ";
+            int id; cin >> id; cin.ignore();
+            cout << "Deadline (YYYY-MM-DD, or none): ";
+            string date;
+            getline(cin, date);
+            setTaskDeadline(data, id, date);
+        }
+        else if (choice == 19) {
+            showNextTask(data);
+        }
+        else if (choice == 20) {
+            takeNextTask(data);
+        }
+        else if (choice == 21) {
+            browsePages(data);
+        }
         else {
-            cout << "Invalid choice. Enter from 1 to 11.\n";
+            cout << "Invalid choice. Enter from 1 to 21.\n";
         }
     }
 
-    // free memory before exit
-    freeAll(data);
+    // let the background saves finish, then free memory before exit
+    data.flushSaves();
+    reportFailedSaves(data);
+    data.close();
     return 0;
 }
 
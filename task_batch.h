@@ -0,0 +1,178 @@
+#ifndef TASK_BATCH_H
+#define TASK_BATCH_H
+
+/*
+ * Command parser for batch mode (--batch ops.txt, or stdin)
+ *
+ * One command per line:
+ *
+ *   add <priority> "description"
+ *   edit <id> <priority> ["description"]   priority 0 / no description = keep
+ *   done <id>
+ *   undone <id>
+ *   del <id>
+ *   due <id> <YYYY-MM-DD|none>             set or drop a task's deadline
+ *   next                                   print the task to do next (priority,
+ *                                          then deadline, then age)
+ *   pop                                    mark that task completed
+ *   undo                                   revert the last change (a clear or
+ *                                          a bulk call is one change)
+ *   redo                                   make the last undone change again
+ *   clear                                  delete every completed task
+ *   list                                   print all tasks (honours --format)
+ *   page <view> <n> [size]                 print page n (1-based, 20 tasks unless
+ *                                          size is given) of all, pending,
+ *                                          completed, priority or p1..p5
+ *   find <words>                           print tasks containing every word
+ *                                          (word* = prefix), see task_index.h
+ *   save                                   write tasks.bin now
+ *   stats [plain|prometheus|json]          print operation counters, latencies and
+ *                                          gauges, see task_metrics.h
+ *
+ * Blank lines and lines starting with '#' are skipped. The description may be
+ * quoted (\" and \\ escapes) or left bare, in which case it is the rest of the
+ * line. Lines are split in place like task_text.h does; only a quoted
+ * description with escapes is copied.
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "task_text.h"
+#include "task_schedule.h"
+#include "task_page.h"
+
+enum BatchOp {
+    BATCH_NONE,     // blank line or comment
+    BATCH_ADD,
+    BATCH_EDIT,
+    BATCH_DONE,
+    BATCH_UNDONE,
+    BATCH_DEL,
+    BATCH_UNDO,
+    BATCH_REDO,
+    BATCH_CLEAR,
+    BATCH_LIST,
+    BATCH_FIND,
+    BATCH_SAVE,
+    BATCH_STATS,
+    BATCH_DUE,
+    BATCH_NEXT,
+    BATCH_POP,
+    BATCH_PAGE
+};
+
+struct BatchCommand {
+    BatchOp op = BATCH_NONE;
+    int id = 0;                 // edit, done, undone, del, due
+    int priority = 0;           // add, edit
+    int64_t deadline = 0;       // due, 0 = none
+    int page = 0;               // page: 1-based number
+    int pageSize = 20;          // page
+    std::string_view text;      // add, edit, find, stats, page (the view); valid until the next parse
+};
+
+inline bool isBatchSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// next whitespace-separated word of [p, e), advancing p past it
+inline std::string_view batchWord(const char*& p, const char* e) {
+    while (p < e && isBatchSpace(*p)) p++;
+    const char* start = p;
+    while (p < e && !isBatchSpace(*p)) p++;
+    return std::string_view(start, (size_t)(p - start));
+}
+
+inline bool batchNumber(const char*& p, const char* e, int& out) {
+    std::string_view w = batchWord(p, e);
+    return parseIntField(w.data(), w.data() + w.size(), out);
+}
+
+// the rest of the line as a description, quoted or bare
+inline const char* batchText(const char* p, const char* e, std::string_view& out, std::string& scratch) {
+    while (p < e && isBatchSpace(*p)) p++;
+    while (e > p && isBatchSpace(e[-1])) e--;
+    if (p == e || *p != '"') {
+        out = std::string_view(p, (size_t)(e - p));
+        return nullptr;
+    }
+    const char* q = ++p;
+    while (q < e && *q != '"' && *q != '\\') q++;
+    if (q < e && *q == '"') {          // no escapes, point straight into the line
+        if (q + 1 != e) return "text after closing quote";
+        out = std::string_view(p, (size_t)(q - p));
+        return nullptr;
+    }
+    scratch.assign(p, q);
+    for (; q < e; q++) {
+        if (*q == '"') {
+            if (q + 1 != e) return "text after closing quote";
+            out = scratch;
+            return nullptr;
+        }
+        if (*q == '\\' && q + 1 < e) q++;
+        scratch += *q;
+    }
+    return "missing closing quote";
+}
+
+// parse one line (without its '\n').
+// Returns nullptr on success, otherwise the reason the line was rejected.
+inline const char* parseBatchLine(const char* b, const char* e, BatchCommand& cmd, std::string& scratch) {
+    cmd = BatchCommand();
+    const char* p = b;
+    std::string_view verb = batchWord(p, e);
+    if (verb.empty() || verb[0] == '#') return nullptr;
+
+    bool needsId = false;
+    if (verb == "add") {
+        cmd.op = BATCH_ADD;
+        if (!batchNumber(p, e, cmd.priority)) return "bad priority";
+        return batchText(p, e, cmd.text, scratch);
+    }
+    else if (verb == "edit") {
+        cmd.op = BATCH_EDIT;
+        if (!batchNumber(p, e, cmd.id)) return "bad task id";
+        if (!batchNumber(p, e, cmd.priority)) return "bad priority";
+        return batchText(p, e, cmd.text, scratch);
+    }
+    else if (verb == "done") { cmd.op = BATCH_DONE; needsId = true; }
+    else if (verb == "undone") { cmd.op = BATCH_UNDONE; needsId = true; }
+    else if (verb == "del") { cmd.op = BATCH_DEL; needsId = true; }
+    else if (verb == "due") {
+        cmd.op = BATCH_DUE;
+        if (!batchNumber(p, e, cmd.id)) return "bad task id";
+        if (!parseDeadline(batchWord(p, e), cmd.deadline)) return "bad deadline (YYYY-MM-DD or none)";
+    }
+    else if (verb == "next") cmd.op = BATCH_NEXT;
+    else if (verb == "pop") cmd.op = BATCH_POP;
+    else if (verb == "undo") cmd.op = BATCH_UNDO;
+    else if (verb == "redo") cmd.op = BATCH_REDO;
+    else if (verb == "clear") cmd.op = BATCH_CLEAR;
+    else if (verb == "list") cmd.op = BATCH_LIST;
+    else if (verb == "page") {
+        cmd.op = BATCH_PAGE;
+        cmd.text = batchWord(p, e);
+        PageView view;
+        int priority;
+        if (!parseView(cmd.text, view, priority)) return "bad view (all, pending, completed, priority, p1..p5)";
+        if (!batchNumber(p, e, cmd.page) || cmd.page < 1) return "bad page number";
+        const char* q = p;
+        if (!batchWord(q, e).empty() && (!batchNumber(p, e, cmd.pageSize) || cmd.pageSize < 1)) return "bad page size";
+    }
+    else if (verb == "find") {
+        cmd.op = BATCH_FIND;
+        return batchText(p, e, cmd.text, scratch);
+    }
+    else if (verb == "save") cmd.op = BATCH_SAVE;
+    else if (verb == "stats") {
+        cmd.op = BATCH_STATS;
+        cmd.text = batchWord(p, e);
+    }
+    else return "unknown command";
+
+    if (needsId && !batchNumber(p, e, cmd.id)) return "bad task id";
+    if (!batchWord(p, e).empty()) return "unexpected text after command";
+    return nullptr;
+}
+
+#endif
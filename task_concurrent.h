@@ -0,0 +1,235 @@
+#ifndef TASK_CONCURRENT_H
+#define TASK_CONCURRENT_H
+
+/*
+ * ConcurrentTaskList - a task set several threads can use at once
+ *
+ * Same layout as the single-threaded programs (task fields in a TaskStore,
+ * slots in list order, id -> slot map), with two levels of locking:
+ *
+ *   structure  one reader-writer lock over the list as a whole. Adding and
+ *              deleting take it exclusively; lookups and scans take it
+ *              shared, so they run side by side.
+ *   shards     the id -> slot map is split into SHARDS maps by task id, each
+ *              with its own reader-writer lock. Readers of a shard's map lock
+ *              it shared; add/remove lock it exclusively.
+ *
+ * Completion never takes the structure lock. Each slot's completed bit and
+ * priority live in one atomic byte, in fixed-size chunks that never move
+ * (apart from the descriptions and the other columns), and the per-priority
+ * completed counts are atomics on cache lines of their own. Marking a task
+ * done is a shard lookup under a shared lock plus one atomic read-modify-write.
+ *
+ * Ids come from an atomic counter, handed out to each thread in blocks of
+ * ID_BLOCK, so adding threads only touch the shared counter once per block.
+ * Ids are therefore unique but not in insertion order across threads.
+ *
+ * Lock order: structure, then shards in index order.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task_store.h"
+#include "task_idmap.h"
+
+struct TaskInfo {
+    int id = 0;
+    std::string description;
+    int priority = 0;
+    bool completed = false;
+};
+
+struct TaskCounts {
+    int live = 0;
+    int done = 0;
+    int prioLive[6] = {};
+    int prioDone[6] = {};
+};
+
+class ConcurrentTaskList {
+public:
+    static constexpr int SHARDS = 64;
+    static constexpr int ID_BLOCK = 64;
+
+    ConcurrentTaskList() : serial(++instances) {}
+    ~ConcurrentTaskList() {
+        for (int c = 0; c < MAX_CHUNKS; c++) delete[] chunks[c].load(std::memory_order_relaxed);
+    }
+    ConcurrentTaskList(const ConcurrentTaskList&) = delete;
+    ConcurrentTaskList& operator=(const ConcurrentTaskList&) = delete;
+
+    // append a task, returns its id (0 once MAX_SLOTS slots are in use)
+    int add(std::string_view desc, int priority) {
+        if (priority < 1 || priority > 5) priority = 1;
+        int id = allocateId();
+        std::unique_lock<std::shared_mutex> lk(structure);
+        if (store.slotCount() >= MAX_SLOTS) return 0;
+        Shard& sh = shardFor(id);
+        std::unique_lock<std::shared_mutex> shardLock(sh.lock);
+        int slot = store.add(id, desc, priority, false);
+        createState(slot).store((uint8_t)priority, std::memory_order_relaxed);
+        sh.slots[id] = slot;
+        return id;
+    }
+
+    bool remove(int id) {
+        std::unique_lock<std::shared_mutex> lk(structure);
+        {
+            Shard& sh = shardFor(id);
+            std::unique_lock<std::shared_mutex> shardLock(sh.lock);
+            const int* slot = sh.slots.find(id);
+            if (!slot) return false;
+            uint8_t before = state(*slot).exchange(0, std::memory_order_relaxed);
+            if (before & DONE_BIT) doneByPriority[before & PRIORITY_MASK].count.fetch_sub(1, std::memory_order_relaxed);
+            store.release(*slot);
+            sh.slots.erase(id);
+        }
+        if (store.needsCompact()) compactLocked();
+        return true;
+    }
+
+    // copy a task out (the copy stays valid after the locks are gone)
+    bool find(int id, TaskInfo& out) const {
+        std::shared_lock<std::shared_mutex> lk(structure);
+        const Shard& sh = shardFor(id);
+        std::shared_lock<std::shared_mutex> shardLock(sh.lock);
+        const int* slot = sh.slots.find(id);
+        if (!slot) return false;
+        int s = *slot;
+        out.id = id;
+        out.description.assign(store.description(s).data(), store.description(s).size());
+        out.priority = store.priority(s);
+        out.completed = isCompleted(s);
+        return true;
+    }
+
+    // lock-free apart from the shard lookup; the structure lock is not touched
+    bool setCompleted(int id, bool done) {
+        const Shard& sh = shardFor(id);
+        std::shared_lock<std::shared_mutex> shardLock(sh.lock);
+        const int* slot = sh.slots.find(id);
+        if (!slot) return false;
+        std::atomic<uint8_t>& st = state(*slot);
+        uint8_t before = done ? st.fetch_or(DONE_BIT, std::memory_order_relaxed)
+                              : st.fetch_and((uint8_t)~DONE_BIT, std::memory_order_relaxed);
+        if (((before & DONE_BIT) != 0) != done) {
+            doneByPriority[before & PRIORITY_MASK].count.fetch_add(done ? 1 : -1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // call fn(id, description, priority, completed) for every task, in list order.
+    // Completions made during the scan may or may not be seen.
+    template <class Fn>
+    void forEach(Fn fn) const {
+        std::shared_lock<std::shared_mutex> lk(structure);
+        for (int s = 0; s < store.slotCount(); s++) {
+            if (store.isLive(s)) fn(store.ids[s], store.description(s), store.priority(s), isCompleted(s));
+        }
+    }
+
+    TaskCounts counts() const {
+        std::shared_lock<std::shared_mutex> lk(structure);
+        TaskCounts c;
+        c.live = store.liveCount;
+        for (int p = 1; p <= 5; p++) {
+            c.prioLive[p] = store.prioLive[p];
+            c.prioDone[p] = doneByPriority[p].count.load(std::memory_order_relaxed);
+            c.done += c.prioDone[p];
+        }
+        return c;
+    }
+
+    int size() const {
+        std::shared_lock<std::shared_mutex> lk(structure);
+        return store.liveCount;    // only add/remove change it, and they hold 'structure'
+    }
+
+private:
+    // per-slot state byte: priority in the low bits, completed in the top bit
+    static constexpr uint8_t DONE_BIT = 0x80;
+    static constexpr uint8_t PRIORITY_MASK = 0x07;
+    static constexpr int CHUNK_BITS = 16;                  // 64 KiB of state bytes per chunk
+    static constexpr int MAX_CHUNKS = 4096;
+    static constexpr int MAX_SLOTS = MAX_CHUNKS << CHUNK_BITS;
+
+    struct alignas(64) Shard {      // one cache line per lock, so shards do not share lines
+        mutable std::shared_mutex lock;
+        FlatIdMap<int> slots;                   // task id -> store slot
+    };
+
+    struct alignas(64) PaddedCount {
+        std::atomic<int> count{ 0 };
+    };
+
+    struct IdBlock {
+        uint64_t owner = 0;     // serial of the list the block came from
+        int next = 0, end = 0;
+    };
+
+    int allocateId() {
+        thread_local IdBlock block;
+        if (block.owner != serial || block.next == block.end) {
+            block.owner = serial;
+            block.next = nextId.fetch_add(ID_BLOCK, std::memory_order_relaxed);
+            block.end = block.next + ID_BLOCK;
+        }
+        return block.next++;
+    }
+
+    Shard& shardFor(int id) { return shards[(unsigned)id % SHARDS]; }
+    const Shard& shardFor(int id) const { return shards[(unsigned)id % SHARDS]; }
+
+    // the chunk of a slot that exists already (its task was published under a lock)
+    std::atomic<uint8_t>& state(int slot) const {
+        std::atomic<uint8_t>* chunk = chunks[slot >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk[slot & ((1 << CHUNK_BITS) - 1)];
+    }
+    // caller holds 'structure' exclusively
+    std::atomic<uint8_t>& createState(int slot) {
+        std::atomic<std::atomic<uint8_t>*>& c = chunks[slot >> CHUNK_BITS];
+        if (c.load(std::memory_order_relaxed) == nullptr) {
+            c.store(new std::atomic<uint8_t>[(size_t)1 << CHUNK_BITS](), std::memory_order_release);
+        }
+        return state(slot);
+    }
+    bool isCompleted(int slot) const {
+        return (state(slot).load(std::memory_order_relaxed) & DONE_BIT) != 0;
+    }
+
+    // caller holds 'structure' exclusively; every shard is locked as well,
+    // since completions look slots up without the structure lock
+    void compactLocked() {
+        for (int i = 0; i < SHARDS; i++) shards[i].lock.lock();
+        std::vector<int> order;
+        order.reserve(store.liveCount);
+        for (int s = 0; s < store.slotCount(); s++) {
+            if (store.isLive(s)) order.push_back(s);
+        }
+        int oldCount = store.slotCount();
+        store.compact(order);
+        for (int s = 0; s < (int)order.size(); s++) {     // order[s] >= s, so this copies forward safely
+            state(s).store(state(order[s]).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            shardFor(store.ids[s]).slots[store.ids[s]] = s;
+        }
+        for (int s = (int)order.size(); s < oldCount; s++) state(s).store(0, std::memory_order_relaxed);
+        for (int i = SHARDS - 1; i >= 0; i--) shards[i].lock.unlock();
+    }
+
+    static inline std::atomic<uint64_t> instances{ 0 };
+    const uint64_t serial;                  // tells this list's id blocks from other lists'
+
+    mutable std::shared_mutex structure;
+    Shard shards[SHARDS];
+    TaskStore store;                        // completed bits unused, see state()
+    std::atomic<std::atomic<uint8_t>*> chunks[MAX_CHUNKS] = {};
+    PaddedCount doneByPriority[6];          // completed tasks per priority
+    alignas(64) std::atomic<int> nextId{ 1 };
+};
+
+#endif
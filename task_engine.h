@@ -0,0 +1,1217 @@
+#ifndef TASK_ENGINE_H
+#define TASK_ENGINE_H
+
+/*
+ * TaskEngine - the task list itself, with no console I/O
+ *
+ * Both programs (and the benchmarks) keep their tasks in one of these; all
+ * they add on top is the menu and the printing. It ties together the pieces
+ * in the other task_*.h headers:
+ *
+ *   list       doubly linked TaskNodes from the node pool, in insertion order
+ *   taskMap    id -> node (FlatIdMap, or std::unordered_map)
+ *   store      the task fields, column by column (TaskStore); slot order is
+ *              list order, which the slot-streaming listings rely on
+ *   textIndex  description words -> ids, built on the first search()
+ *   journal    bounded undo/redo history; deleted tasks stay hidden in their
+ *              store slot until it forgets them
+ *   schedule   pending tasks by priority, deadline and id (TaskSchedule),
+ *              built on the first peekNext() and kept up to date from then on
+ *   ranks      per-block task counts in the store (SlotRanks), built on the
+ *              first page() so a page costs O(log n + page size)
+ *   log        tasks.log, once load() opened it; every change is appended
+ *   layout     which record of tasks.bin holds which task (SnapshotLayout), and
+ *   dirty      the tasks changed since it was written: checkpoint() patches
+ *              just their records when nothing else changed (task_snapshot.h)
+ *
+ * Every public operation is timed into metrics() (task_metrics.h; compiled
+ * out with -DTASK_METRICS=0) and gauges() reports the sizes behind them.
+ *
+ * Persistence is optional: an engine that never calls load() keeps its
+ * tasks in memory only, every log call is then a no-op.
+ *
+ * Text files can also be written in the background (saveInBackground,
+ * task_persist.h): the caller's thread only copies the store, a worker
+ * formats and writes the copy, so edits carry on meanwhile. setAutosave()
+ * exports tasks.txt that way every so often while changes come in.
+ *
+ * A lazy load (setLazyLoad) reads only ids, priorities and flags at startup:
+ * descriptions are borrowed from the mapped tasks.bin or tasks.txt and their
+ * pages are read the first time a search, an edit or a listing touches them.
+ * Startup then costs the task count, not the text size, apart from a text
+ * import, which has to scan the file for line ends once.
+ *
+ * Nothing here prints. Mutators return false / 0 (or a BulkResult) when
+ * nothing was done, load() returns a LoadReport describing what it found,
+ * and the caller decides what to tell the user.
+ *
+ * BasicTaskEngine is a template over those choices (see task_policy.h);
+ * TaskEngine is the configuration both programs use. With the Locked sync
+ * policy every operation takes the engine's mutex, so one engine can be
+ * shared between threads; the accessors that hand out pointers or references
+ * (count, front, tasks, find, metrics) do not, hold lock() while using them.
+ * The default SingleThreaded policy is not thread-safe; see task_concurrent.h
+ * for a list built for many concurrent writers.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "task_store.h"
+#include "task_policy.h"
+#include "task_snapshot.h"
+#include "task_text.h"
+#include "task_log.h"
+#include "task_index.h"
+#include "task_undo.h"
+#include "task_parallel.h"
+#include "task_metrics.h"
+#include "task_schedule.h"
+#include "task_persist.h"
+
+// bulk calls take a pointer + count and report everything in one result
+struct NewTask {
+    std::string_view description;
+    int priority;       // outside 1..5 becomes 1
+};
+
+struct BulkResult {
+    int applied = 0;            // tasks added / completed / deleted / touched by undo
+    int firstId = 0;            // add: id of the first new task (the rest follow in order), 0 if none
+    std::vector<int> rejected;  // add: indexes with an empty description; otherwise ids not found
+};
+
+struct StorageFiles {
+    std::string snapshot = "tasks.bin";
+    std::string text = "tasks.txt";
+    std::string log = "tasks.log";
+    std::string foldedLog() const { return log + ".old"; }
+};
+
+// what load() found, for the caller to report
+struct LoadReport {
+    bool fromSnapshot = false;          // tasks came from the snapshot
+    bool invalidSnapshot = false;       // the snapshot was unreadable, the text file was read instead
+    std::vector<ParseError> textErrors; // malformed text file lines (skipped)
+    bool droppedLog = false;            // the text file replaced the saved tasks, the log was deleted
+    size_t replayed = 0;                // log records applied on top
+    size_t recovered = 0;               // of those, the ones no clean exit followed (lost by a crash
+                                        // but for the log); the rest a lazy session kept on purpose
+    bool logOpen = false;               // false: changes are only kept by checkpoint()
+};
+
+template <class IndexPolicy = FlatIndex, class NodePolicy = SlabNodes, class SyncPolicy = SingleThreaded,
+          class StorePolicy = WithPriorityIndex>
+class BasicTaskEngine {
+public:
+    using Store = typename StorePolicy::Store;
+    using Mutex = typename SyncPolicy::Mutex;
+
+    // fold tasks.log into tasks.bin in the background once it is this big
+    static constexpr uint64_t LOG_COMPACT_BYTES = 8 << 20;
+
+    BasicTaskEngine() = default;
+    ~BasicTaskEngine() { close(); }
+    BasicTaskEngine(const BasicTaskEngine&) = delete;
+    BasicTaskEngine& operator=(const BasicTaskEngine&) = delete;
+
+    // ---- setup ----
+
+    // clears the undo history, so call it before the first change
+    void setUndoLimits(size_t steps, size_t bytes) { journal.setLimits(steps, bytes); }
+
+    // threads for scans of big stores, 0 = all cores
+    void setScanThreads(int threads) {
+        scanThreads = threads;
+        workers.reset();
+    }
+
+    void setStorageFiles(const StorageFiles& f) { files = f; }
+    const StorageFiles& storageFiles() const { return files; }
+
+    // borrow descriptions from the loaded files instead of copying them (see
+    // above); the files are kept mapped until close(). Call it before load().
+    void setLazyLoad(bool lazy) { lazyLoad = lazy; }
+
+    // open tasks.log only when the first change is logged, so loading a list
+    // that is only read creates no file (and starts no flusher thread). Call
+    // it before load().
+    void setLogOnDemand(bool onDemand) { logOnDemand = onDemand; }
+
+    // ---- reading ----
+
+    int count() const { return totalTasks; }
+    const TaskNode* front() const { return head; }     // walk with ->next
+    const Store& tasks() const { return store; }
+    bool canUndo() const { return journal.canUndo(); }
+    bool canRedo() const { return journal.canRedo(); }
+
+    TaskMetrics& metrics() { return stats; }
+
+    // held across several reads when the engine is shared (a no-op when SingleThreaded)
+    std::unique_lock<Mutex> lock() const { return std::unique_lock<Mutex>(mtx); }
+
+    MetricGauges gauges() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricGauges g;
+        g.tasks = totalTasks;
+        g.storeSlots = store.slotCount();
+        g.freedSlots = store.freedCount;
+        g.mapEntries = (long long)taskMap.size();
+        g.mapLoadFactor = taskMap.loadFactor();
+        g.undoBytes = (long long)journal.usedBytes();
+        g.logBytes = log.isOpen() ? (long long)log.bytes() : 0;
+        g.indexTokens = (long long)textIndex.tokenCount();
+        return g;
+    }
+
+    const TaskNode* find(int id) const {
+        TaskNode* const* n = taskMap.find(id);
+        return n ? *n : nullptr;
+    }
+
+    // slots for which keep(slot) is true, ascending (in list order); big
+    // stores are scanned on the worker pool, see task_parallel.h
+    template <class Keep>
+    std::vector<int> filter(Keep keep) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_SCAN);
+        timer.items((uint64_t)store.slotCount());
+        return filterSlots(store, scanPool(), keep);
+    }
+
+    // ids (ascending) of the tasks matching every word of 'query' (see task_index.h);
+    // the index is built on the first search and kept up to date from then on
+    std::vector<int> search(std::string_view query) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_SEARCH);
+        if (!textIndex.isBuilt()) {
+            textIndex.markBuilt();
+            for (TaskNode* cur = head; cur; cur = cur->next) textIndex.add(cur->id, store.description(cur->slot));
+        }
+        return textIndex.search(query);
+    }
+
+    // id of the pending task to do next (lowest priority number, then earliest
+    // deadline, then oldest), 0 if none; O(1) once the schedule is built
+    int peekNext() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_NEXT);
+        return nextPending();
+    }
+
+    // page 'number' (0-based) of a view, 'size' tasks per page (see task_page.h);
+    // past the last page the page is empty
+    TaskPage page(PageView view, size_t number, size_t size, int priority = 0) {
+        std::lock_guard<Mutex> guard(mtx);
+        TaskPage p;
+        p.view = view;
+        p.priority = view == PageView::Priority ? priority : 0;
+        p.size = size;
+        p.first = number * size;
+        return pageFrom(p);
+    }
+
+    // the page after / before 'current', continuing from the task it ended /
+    // started with, so changes elsewhere in the list do not shift it. At either
+    // end of the view the last / first page is returned.
+    TaskPage nextPage(const TaskPage& current) {
+        std::lock_guard<Mutex> guard(mtx);
+        TaskPage p = current;
+        if (!store.ranks.isBuilt()) store.buildRanks();
+        TaskNode** last = current.lastId ? taskMap.find(current.lastId) : nullptr;
+        p.first = last ? positionBefore(store, p.view, p.priority, current.lastPriority, (*last)->slot + 1)
+                       : current.first + current.slots.size();
+        size_t total = viewSize(store, p.view, p.priority);
+        if (p.first >= total) p.first = total > p.size ? total - p.size : 0;
+        return pageFrom(p);
+    }
+
+    TaskPage prevPage(const TaskPage& current) {
+        std::lock_guard<Mutex> guard(mtx);
+        TaskPage p = current;
+        if (!store.ranks.isBuilt()) store.buildRanks();
+        TaskNode** first = current.firstId ? taskMap.find(current.firstId) : nullptr;
+        size_t end = first ? positionBefore(store, p.view, p.priority, current.firstPriority, (*first)->slot)
+                           : current.first;
+        p.first = end > p.size ? end - p.size : 0;
+        return pageFrom(p);
+    }
+
+    std::vector<int> slotsInListOrder() const {
+        std::lock_guard<Mutex> guard(mtx);
+        std::vector<int> order;
+        order.reserve(totalTasks);
+        for (TaskNode* cur = head; cur; cur = cur->next) order.push_back(cur->slot);
+        return order;
+    }
+
+    // ---- changes (all logged; everything but adding is one undo step) ----
+
+    // append tasks[0..count) in order: the nodes are chained together first and
+    // spliced onto the tail once, and the map and store are sized for the batch up front
+    BulkResult addTasks(const NewTask* newTasks, size_t n) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_ADD);
+        timer.items(n);
+        BulkResult result;
+        size_t needed = taskMap.size() + n;
+        if (needed > taskMap.capacity()) taskMap.reserve(grownCapacity(taskMap.size(), needed));
+        if (store.slotCount() + n > store.ids.capacity()) {
+            store.reserve(grownCapacity(store.ids.capacity(), store.slotCount() + n));
+        }
+
+        TaskNode* first = nullptr;
+        TaskNode* last = nullptr;
+        for (size_t i = 0; i < n; i++) {
+            std::string_view desc = newTasks[i].description;
+            if (desc.empty()) {
+                result.rejected.push_back((int)i);
+                continue;
+            }
+            int pr = newTasks[i].priority;
+            if (pr < 1 || pr > 5) pr = 1;
+            int id = nextId++;
+            TaskNode* node = makeNode(id, desc, pr, false);
+            node->prev = last;
+            if (last) last->next = node;
+            else first = node;
+            last = node;
+            taskMap.insert(id, node);
+            textIndex.add(id, desc);
+            reschedule(id, node->slot);
+            log.add(id, desc, pr, false);
+            markRewrite();  // a new record
+            if (result.applied++ == 0) result.firstId = id;
+        }
+
+        if (first) {
+            first->prev = tail;
+            if (tail) tail->next = first;
+            else head = first;
+            tail = last;
+            totalTasks += result.applied;
+            afterChange();
+        }
+        return result;
+    }
+
+    // new task at the end of the list; returns its id, or 0 if the description is empty
+    int add(std::string_view desc, int priority) {
+        NewTask task = { desc, priority };
+        return addTasks(&task, 1).firstId;
+    }
+
+    // empty description / priority outside 1..5 keep the old value
+    bool update(int id, std::string_view desc, int priority) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_EDIT);
+        TaskNode** found = taskMap.find(id);
+        if (!found) return false;
+        int s = (*found)->slot;
+        bool newText = !desc.empty() && desc != store.description(s);
+        bool newPriority = priority >= 1 && priority <= 5 && priority != store.priority(s);
+        if (!newText && !newPriority) return true;
+
+        // the new text is copied once into 'text', swapped into the store, and
+        // the old one it gets back moves on into the undo step
+        journal.begin();
+        int oldPriority = newPriority ? store.priority(s) : 0;
+        TaskDescription text;
+        if (newText) {
+            text.assign(desc.data(), desc.size());
+            swapDescription(*found, text);
+        }
+        if (newPriority) {
+            store.setPriority(s, priority);
+            reschedule(id, s);
+        }
+        journal.recordEdit(id, newText, std::move(text), oldPriority);
+        commitUndoStep();
+        s = (*found)->slot;     // the commit may have compacted the store
+        log.edit(id, store.description(s), store.priority(s));
+        if (newText) markRewrite();     // a description in the blob
+        else markDirty(id);
+        afterChange();
+        return true;
+    }
+
+    // one undo step for the whole call
+    BulkResult completeMany(const int* ids, size_t n, bool done = true) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_COMPLETE);
+        timer.items(n);
+        BulkResult result;
+        journal.begin();
+        for (size_t i = 0; i < n; i++) {
+            TaskNode** found = taskMap.find(ids[i]);
+            if (!found) {
+                result.rejected.push_back(ids[i]);
+                continue;
+            }
+            int s = (*found)->slot;
+            if (store.isCompleted(s) != done) journal.recordComplete(ids[i], !done);
+            store.setCompleted(s, done);
+            reschedule(ids[i], s);
+            log.complete(ids[i], done);
+            markDirty(ids[i]);
+            result.applied++;
+        }
+        commitUndoStep();
+        if (result.applied) afterChange();
+        return result;
+    }
+
+    bool setCompleted(int id, bool done) {
+        return completeMany(&id, 1, done).applied == 1;
+    }
+
+    // mark the next task (see peekNext) completed, as one undo step, and return
+    // its id; 0 if nothing is pending
+    int popNext() {
+        std::lock_guard<Mutex> guard(mtx);
+        int id;
+        {
+            MetricTimer timer(stats, OP_NEXT);
+            id = nextPending();
+        }
+        if (id) completeMany(&id, 1, true);
+        return id;
+    }
+
+    // seconds since the epoch, 0 = none (see task_schedule.h); one undo step
+    bool setDeadline(int id, int64_t when) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_DEADLINE);
+        TaskNode** found = taskMap.find(id);
+        if (!found) return false;
+        int s = (*found)->slot;
+        int64_t old = store.deadline(s);
+        if (old == when) return true;
+        journal.begin();
+        store.setDeadline(s, when);
+        reschedule(id, s);
+        journal.recordDeadline(id, old);
+        commitUndoStep();
+        log.deadline(id, when);
+        markDirty(id);
+        afterChange();
+        return true;
+    }
+
+    // one undo step for the whole call: undo brings every task back, in their original order
+    BulkResult deleteMany(const int* ids, size_t n) {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_DELETE);
+        timer.items(n);
+        BulkResult result;
+        journal.begin();
+        for (size_t i = 0; i < n; i++) {
+            TaskNode** found = taskMap.find(ids[i]);
+            if (!found) {
+                result.rejected.push_back(ids[i]);
+                continue;
+            }
+            // the map gives us the node directly, detach it without rescanning the list
+            // (its fields stay in the store slot, which the undo step keeps)
+            detachForUndo(*found);
+            log.remove(ids[i]);
+            markDirty(ids[i]);
+            result.applied++;
+        }
+        commitUndoStep();
+        if (result.applied) afterChange();
+        return result;
+    }
+
+    bool remove(int id) {
+        return deleteMany(&id, 1).applied == 1;
+    }
+
+    // delete every completed task as one undo step, returns how many
+    int removeCompleted() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_CLEAR);
+        journal.begin();
+        int removed = clearCompleted(true);
+        timer.items((uint64_t)removed);
+        commitUndoStep();
+        if (removed > 0) {
+            log.clearCompleted();
+            afterChange();
+        }
+        return removed;
+    }
+
+    // revert the last change (an edit, a completion, a delete, or a whole bulk
+    // call / clear); deleted tasks come back where they were. applied = tasks touched
+    // (0 if there was nothing to undo), firstId = one of them.
+    BulkResult undo() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_UNDO);
+        BulkResult result;
+        journal.undo([&](UndoDelta& d, bool undoing) {
+            applyUndoDelta(d, undoing);
+            if (result.applied++ == 0) result.firstId = d.id;
+        });
+        timer.items((uint64_t)result.applied);
+        if (result.applied) afterChange();
+        return result;
+    }
+
+    // make the last undone change again
+    BulkResult redo() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_REDO);
+        BulkResult result;
+        journal.redo([&](UndoDelta& d, bool undoing) {
+            applyUndoDelta(d, undoing);
+            if (result.applied++ == 0) result.firstId = d.id;
+        });
+        timer.items((uint64_t)result.applied);
+        if (result.applied) afterChange();
+        return result;
+    }
+
+    // ---- persistence ----
+
+    // Startup: load the snapshot and replay the log on top of it, then start logging.
+    // The text file is read instead when there is no snapshot, or when it is newer
+    // than both the snapshot and the log (e.g. a fresh import). The log only
+    // applies to the state it was recorded against, so it is dropped then.
+    LoadReport load() {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_LOAD);
+        namespace fs = std::filesystem;
+        LoadReport report;
+        std::error_code ec;
+        bool haveSnapshot = fs::exists(files.snapshot, ec);
+        bool haveText = fs::exists(files.text, ec);
+        bool haveLog = fs::exists(files.log, ec);
+        bool haveFolded = fs::exists(files.foldedLog(), ec);
+        bool textIsNewest = haveText &&
+            (!haveSnapshot || fs::last_write_time(files.text, ec) > fs::last_write_time(files.snapshot, ec)) &&
+            (!haveLog || fs::last_write_time(files.text, ec) > fs::last_write_time(files.log, ec));
+
+        if (haveSnapshot && !textIsNewest) {
+            report.fromSnapshot = loadSnapshot(files.snapshot);
+            report.invalidSnapshot = !report.fromSnapshot;
+        }
+        if (!report.fromSnapshot) loadText(files.text, report.textErrors);
+
+        uint64_t lastSeq = snapshotSequence;
+        if (report.fromSnapshot || !haveSnapshot) {
+            size_t sessionEnds = 0;
+            auto apply = [&](const LogRecord& r) {
+                if (r.type == LOG_SESSION_END) {
+                    sessionEnds++;
+                    report.recovered = 0;   // everything before it was kept on purpose
+                    return;
+                }
+                applyLogRecord(r);
+                report.recovered++;
+            };
+            report.replayed += replayOpLog(files.foldedLog(), snapshotSequence, apply, lastSeq);
+            report.replayed += replayOpLog(files.log, snapshotSequence, apply, lastSeq);
+            report.replayed -= sessionEnds;
+            // replayed deletes release their slots and restores take new ones at the end
+            if (report.replayed > 0 && (store.needsCompact() || !slotsFollowList())) compactStore();
+        }
+        else if (haveLog || haveFolded) {
+            report.droppedLog = true;
+            std::remove(files.log.c_str());
+            std::remove(files.foldedLog().c_str());
+        }
+
+        report.logOpen = log.open(files.log, lastSeq + 1, logOnDemand);
+        cleanSequence = report.recovered ? 0 : lastSeq;
+        // start the session from a snapshot that matches the log. A lazy load
+        // keeps appending to a replayed log instead (writing the snapshot would
+        // read every description); maybeCompact() folds it once it is big.
+        bool keepLog = lazyLoad && report.fromSnapshot && !haveFolded;
+        if (report.logOpen && ((report.replayed > 0 && !keepLog) || haveFolded || (!report.fromSnapshot && haveText))) {
+            checkpoint();
+        }
+        timer.items((uint64_t)totalTasks);
+        return report;
+    }
+
+    // write the snapshot with everything logged so far, then empty the log.
+    // If the only changes since the last one are to tasks already in the file
+    // (completed, priority, deadline, deleted or brought back), just their
+    // records are rewritten, in place; otherwise the whole file. False if the
+    // snapshot could not be written or tasks.log could not be emptied after it.
+    bool checkpoint() {
+        std::lock_guard<Mutex> guard(mtx);
+        return saveSnapshot(true);
+    }
+
+    // end of a session: checkpoint(), or after a lazy load that is logging
+    // patch the snapshot in place if that is enough, else just wait for
+    // tasks.log to reach the disk, since rewriting the snapshot would read every
+    // description; the next load() replays the log instead. The log then ends
+    // with LOG_SESSION_END, so that load() does not report it as recovered.
+    bool persist() {
+        std::lock_guard<Mutex> guard(mtx);
+        bool logging = log.isOpen() && !log.failed();   // a failed log keeps nothing: write the snapshot
+        if (logging && log.lastSequence() == snapshotSequence) return true;   // nothing changed since
+        if (lazyLoad && logging) {
+            if (saveSnapshot(false)) return true;
+            if (log.lastSequence() != cleanSequence) log.endSession();
+            if (log.sync()) return true;
+        }
+        return saveSnapshot(true);
+    }
+
+    // one line per task: id|description|priority|completed[|deadline] (see task_text.h);
+    // a '|' in a description becomes a space. Written next to 'path' and renamed
+    // over it, so descriptions borrowed from the old file stay readable.
+    bool exportText(const std::string& path) const {
+        std::lock_guard<Mutex> guard(mtx);
+        MetricTimer timer(stats, OP_EXPORT);
+        timer.items((uint64_t)totalTasks);
+        std::vector<int> slots = slotsInListOrder();
+        return writeFileAtomically(path, [&](std::ostream& out) { writeTaskLines(out, store, slots); });
+    }
+
+    // ---- background saves (task_persist.h) ----
+
+    // write 'path' on the background thread from a copy of the tasks as they
+    // are now: write(std::ostream&, const Store&, const std::vector<int>& slots)
+    // formats the copy, slots in list order. Returns once the copy is taken;
+    // flushSaves() waits for the file, failedSaves() reports failures.
+    template <class Write>
+    void saveInBackground(const std::string& path, Write write) {
+        std::lock_guard<Mutex> guard(mtx);
+        queueSave(path, write, false);
+    }
+
+    // exportText() in the background. The file is dated when the copy was
+    // taken, not when it was finished, so load() still prefers the changes
+    // logged after the copy over it.
+    void exportTextInBackground(const std::string& path) {
+        std::lock_guard<Mutex> guard(mtx);
+        queueSave(path, writeTaskLines<Store>, true);
+    }
+
+    // export files.text in the background after a change, at most once per 'every';
+    // 0 = never
+    void setAutosave(std::chrono::seconds every) { autosaveEvery = every; }
+
+    // the barrier before exiting: every background save has finished
+    void flushSaves() { saver.flush(); }
+    // (and tasks.log, if it failed, see afterChange(); tasks.bin too if the
+    // snapshot written instead failed as well)
+    std::vector<std::string> failedSaves() {
+        std::vector<std::string> failed = saver.takeFailures();
+        std::lock_guard<Mutex> guard(mtx);
+        failed.insert(failed.end(), logFailures.begin(), logFailures.end());
+        logFailures.clear();
+        return failed;
+    }
+
+    // sync tasks.log, then close it and stop its flusher until the next change
+    // (for a list that has gone quiet; the engine stays loaded)
+    void releaseLog() {
+        std::lock_guard<Mutex> guard(mtx);
+        log.release();
+    }
+
+    // stop logging and drop every task (the files are left as they are)
+    void close() {
+        std::lock_guard<Mutex> guard(mtx);
+        log.close();
+        clear();
+    }
+
+private:
+    // ---- list / map bookkeeping ----
+
+    // a node from the pool for a task already in the store
+    TaskNode* nodeForSlot(int id, int slot) {
+        TaskNode* n = pool.acquire();
+        n->id = id;
+        n->slot = slot;
+        n->next = n->prev = nullptr;
+        return n;
+    }
+
+    TaskNode* makeNode(int id, std::string_view desc, int priority, bool completed) {
+        return nodeForSlot(id, store.add(id, desc, priority, completed));
+    }
+
+    // link at the end in O(1) using the tail pointer
+    void appendNode(TaskNode* n) {
+        n->next = nullptr;
+        n->prev = tail;
+        if (tail == nullptr) head = n;
+        else tail->next = n;
+        tail = n;
+    }
+
+    // O(1), no scan for the predecessor
+    void unlinkNode(TaskNode* n) {
+        if (n->prev) n->prev->next = n->next;
+        else head = n->next;
+        if (n->next) n->next->prev = n->prev;
+        else tail = n->prev;
+        n->next = n->prev = nullptr;
+    }
+
+    // new task at the end of the list (loading and replay; not logged)
+    TaskNode* insertTask(int id, std::string_view desc, int priority, bool completed) {
+        return insertSlot(id, store.add(id, desc, priority, completed));
+    }
+
+    // the same for a task already added to the store at 'slot'
+    TaskNode* insertSlot(int id, int slot) {
+        TaskNode* n = nodeForSlot(id, slot);
+        appendNode(n);
+        taskMap[id] = n;
+        textIndex.add(id, store.description(slot));
+        reschedule(id, slot);
+        nextId = std::max(nextId, id + 1);
+        totalTasks++;
+        return n;
+    }
+
+    // take a task out of the list and give its node back to the pool.
+    // The fields stay in the (hidden) store slot, which is returned: the caller
+    // records it for undo or releases it.
+    int detachTask(TaskNode* n) {
+        int slot = n->slot;
+        unlinkNode(n);
+        textIndex.remove(n->id, store.description(slot));
+        schedule.remove(n->id);
+        store.hide(slot);
+        taskMap.erase(n->id);
+        pool.release(n);
+        totalTasks--;
+        return slot;
+    }
+
+    // detach a task and put it on the current undo step, together with the task
+    // before it, which is where undo links it back in
+    void detachForUndo(TaskNode* n) {
+        int id = n->id;
+        int after = n->prev ? n->prev->id : 0;
+        int slot = detachTask(n);
+        journal.recordDelete(id, slot, after, store.slotBytes(slot));
+    }
+
+    // put a task back right behind 'prev' (nullptr = at the head) in O(1)
+    void relinkAfter(TaskNode* n, TaskNode* prev) {
+        n->prev = prev;
+        n->next = prev ? prev->next : head;
+        if (n->next) n->next->prev = n;
+        else tail = n;
+        if (prev) prev->next = n;
+        else head = n;
+        store.revive(n->slot);
+        taskMap[n->id] = n;
+        textIndex.add(n->id, store.description(n->slot));
+        reschedule(n->id, n->slot);
+        totalTasks++;
+        // ensure nextId stays greater than any id
+        nextId = std::max(nextId, n->id + 1);
+    }
+
+    void setDescription(TaskNode* n, std::string_view desc) {
+        textIndex.remove(n->id, store.description(n->slot));
+        store.setDescription(n->slot, desc);
+        textIndex.add(n->id, desc);
+    }
+
+    TaskPage pageFrom(TaskPage& p) {
+        MetricTimer timer(stats, OP_LIST);
+        if (!store.ranks.isBuilt()) store.buildRanks();
+        fillPage(store, p);
+        timer.items(p.slots.size());
+        return std::move(p);
+    }
+
+    // ---- background saves ----
+
+    template <class Write>
+    void queueSave(const std::string& path, Write write, bool dateByCopy) {
+        MetricTimer timer(stats, OP_EXPORT);
+        timer.items((uint64_t)totalTasks);
+        std::filesystem::file_time_type taken = std::filesystem::file_time_type::clock::now();
+        saver.submit(path, [path, write, dateByCopy, taken, copy = store, slots = slotsInListOrder()] {
+            bool ok = writeFileAtomically(path, [&](std::ostream& out) { write(out, copy, slots); });
+            std::error_code ec;
+            if (ok && dateByCopy) std::filesystem::last_write_time(path, taken, ec);
+            return ok;
+        });
+        lastAutosave = std::chrono::steady_clock::now();
+    }
+
+    // after every change: fold the log when it is big, autosave when it is time
+    // (so an idle session writes nothing)
+    void afterChange() {
+        if (log.failed()) rescueLog();
+        else maybeCompact();
+        if (autosaveEvery.count() > 0 && std::chrono::steady_clock::now() - lastAutosave >= autosaveEvery) {
+            queueSave(files.text, writeTaskLines<Store>, true);
+        }
+    }
+
+    // tasks.log could not be written (disk full, I/O error), so it ends at its
+    // last good record and the changes since are only in memory: write them
+    // all to a fresh snapshot, which empties the log and lets it carry on.
+    // Once per failure, as a full write on every change of a big list would be
+    // slow; checkpoint() and persist() try again.
+    void rescueLog() {
+        if (logFailureSeen) return;
+        saveSnapshot(true);
+        if (log.failed() && snapshotSequence < log.lastSequence()) logFailures.push_back(files.snapshot);
+    }
+
+    // bring the task's schedule entry up to date (only pending tasks have one)
+    void reschedule(int id, int slot) {
+        if (!schedule.isBuilt()) return;
+        if (store.isLive(slot) && !store.isCompleted(slot)) schedule.set(id, store.priority(slot), store.deadline(slot));
+        else schedule.remove(id);
+    }
+
+    // the schedule's head, building it from the pending tasks the first time
+    int nextPending() {
+        if (!schedule.isBuilt()) {
+            std::vector<TaskSchedule::Entry> pending;
+            pending.reserve((size_t)(store.liveCount - store.doneCount));
+            for (TaskNode* cur = head; cur; cur = cur->next) {
+                int s = cur->slot;
+                if (!store.isCompleted(s)) pending.push_back(TaskSchedule::Entry{ store.deadline(s), cur->id, store.priority(s) });
+            }
+            schedule.build(std::move(pending));
+        }
+        return schedule.top();
+    }
+
+    // the task gets 'text' as its description, 'text' gets the old one
+    void swapDescription(TaskNode* n, TaskDescription& text) {
+        textIndex.remove(n->id, store.description(n->slot));
+        store.swapDescription(n->slot, text);
+        textIndex.add(n->id, store.description(n->slot));
+    }
+
+    // detach every completed task, returns how many. Only the flags column is
+    // scanned to find them (on the worker pool for big stores), then the map
+    // gives each one's node. The tasks go on the current undo step, or are
+    // released if !undoable.
+    int clearCompleted(bool undoable) {
+        std::vector<int> done = filter([&](int s) {
+            return store.flags[s] == (Store::LIVE | Store::DONE);
+        });
+        for (int& s : done) s = store.ids[s];
+        for (int id : done) {
+            TaskNode* n = *taskMap.find(id);
+            if (undoable) detachForUndo(n);
+            else store.release(detachTask(n));
+            markDirty(id);
+        }
+        return (int)done.size();
+    }
+
+    // ---- store maintenance ----
+
+    // squeeze out released slots and put the rest in list order, renumbering
+    // everything that points at a slot. The hidden slots the undo history still
+    // needs keep their place among the list's (slots are in list order apart from
+    // them), so a task undo brings back is in list order again as well.
+    void compactStore() {
+        MetricTimer timer(stats, OP_COMPACT);
+        timer.items((uint64_t)store.slotCount());
+        std::vector<int> hidden;
+        journal.forEachHiddenSlot([&](int s) { hidden.push_back(s); });
+        std::sort(hidden.begin(), hidden.end());
+        std::vector<int> order;
+        order.reserve(store.liveCount + hidden.size());
+        size_t h = 0;
+        for (TaskNode* cur = head; cur; cur = cur->next) {
+            while (h < hidden.size() && hidden[h] < cur->slot) order.push_back(hidden[h++]);
+            order.push_back(cur->slot);
+        }
+        order.insert(order.end(), hidden.begin() + (std::ptrdiff_t)h, hidden.end());
+        std::vector<int> renumbered(store.slotCount(), -1);
+        for (size_t i = 0; i < order.size(); i++) renumbered[order[i]] = (int)i;
+        store.compact(order);
+        for (TaskNode* cur = head; cur; cur = cur->next) cur->slot = renumbered[cur->slot];
+        journal.forEachSlot([&](int& s) { s = renumbered[s]; });
+    }
+
+    // true while slot order is list order (what the priority listing relies on)
+    bool slotsFollowList() const {
+        int last = -1;
+        for (const TaskNode* cur = head; cur; cur = cur->next) {
+            if (cur->slot < last) return false;
+            last = cur->slot;
+        }
+        return true;
+    }
+
+    // grow a capacity geometrically, so batch after batch of reserve() stays amortised O(1)
+    static size_t grownCapacity(size_t current, size_t needed) {
+        return std::max(needed, current * 2);
+    }
+
+    // pool for filter(), or nullptr while the store is small enough to scan serially
+    WorkerPool* scanPool() {
+        if ((size_t)store.slotCount() < PARALLEL_MIN_SLOTS) return nullptr;
+        if (!workers) workers.reset(new WorkerPool(scanThreads));
+        return workers.get();
+    }
+
+    // ---- undo ----
+
+    // close the undo step begun by the caller; steps that no longer fit the
+    // history's limits give their deleted tasks' slots back to the store
+    void commitUndoStep() {
+        journal.commit([&](int slot) { store.release(slot); });
+        if (store.needsCompact()) compactStore();
+    }
+
+    // undo (undoing = true) or redo one delta; edit and complete deltas swap
+    // their value with the task's, so the same delta can be applied again later
+    void applyUndoDelta(UndoDelta& d, bool undoing) {
+        if (d.kind == UNDO_DELETE && undoing) {
+            TaskNode** prev = d.after ? taskMap.find(d.after) : nullptr;
+            if (!prev) d.after = 0;
+            TaskNode* n = nodeForSlot(d.id, d.slot);
+            relinkAfter(n, prev ? *prev : nullptr);
+            int s = n->slot;
+            log.restore(d.id, store.description(s), store.priority(s), store.isCompleted(s), d.after);
+            if (int64_t when = store.deadline(s)) log.deadline(d.id, when);
+            markDirty(d.id);    // back where its (removed) record is
+            return;
+        }
+        TaskNode** found = taskMap.find(d.id);
+        if (!found) return; // cannot happen: every later change was undone first
+        TaskNode* n = *found;
+        int s = n->slot;
+        switch (d.kind) {
+        case UNDO_EDIT:
+            if (d.hasText) swapDescription(n, d.text);
+            if (d.priority != 0) {
+                int current = store.priority(s);
+                store.setPriority(s, d.priority);
+                d.priority = (uint8_t)current;
+                reschedule(d.id, s);
+            }
+            log.edit(d.id, store.description(s), store.priority(s));
+            if (d.hasText) markRewrite();
+            else markDirty(d.id);
+            break;
+        case UNDO_COMPLETE: {
+            bool current = store.isCompleted(s);
+            store.setCompleted(s, d.completed);
+            d.completed = current;
+            reschedule(d.id, s);
+            log.complete(d.id, store.isCompleted(s));
+            markDirty(d.id);
+            break;
+        }
+        case UNDO_DEADLINE: {
+            int64_t current = store.deadline(s);
+            store.setDeadline(s, d.deadline);
+            d.deadline = current;
+            reschedule(d.id, s);
+            log.deadline(d.id, store.deadline(s));
+            markDirty(d.id);
+            break;
+        }
+        case UNDO_DELETE: // redo
+            d.after = n->prev ? n->prev->id : 0;
+            d.slot = detachTask(n);
+            log.remove(d.id);
+            markDirty(d.id);
+            break;
+        }
+    }
+
+    // ---- persistence ----
+
+    // 'id' no longer matches its record in tasks.bin (if it has one there)
+    void markDirty(int id) {
+        if (!layout.isValid()) return;
+        if (dirty.size() >= patchLimit()) {
+            std::sort(dirty.begin(), dirty.end());
+            dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+            // by now writing the whole file is about as cheap as seeking to each record
+            if (dirty.size() >= patchLimit()) return markRewrite();
+        }
+        dirty.push_back(id);
+    }
+
+    // records a patch may rewrite, and removed records the file may keep
+    size_t patchLimit() const { return (size_t)layout.header().count / 4 + 64; }
+
+    // the file cannot be patched into the current state: the next checkpoint rewrites it
+    void markRewrite() {
+        if (!layout.isValid()) return;
+        layout.clear();
+        std::vector<int>().swap(dirty);
+    }
+
+    // checkpoint() without taking the lock; mayRewrite = false only patches
+    bool saveSnapshot(bool mayRewrite) {
+        MetricTimer timer(stats, OP_SAVE);
+        timer.items((uint64_t)totalTasks);
+        compactor.wait(); // it writes the same file
+        if (log.failed()) {
+            if (!logFailureSeen) logFailures.push_back(files.log);
+            logFailureSeen = true;
+            if (!mayRewrite) return false;
+            markRewrite();  // the log is broken: every task goes into a whole new file
+        }
+        // the log's sequence even if it has stopped: its file may hold records up to there
+        uint64_t seq = std::max(snapshotSequence, log.lastSequence());
+        size_t patched = 0;
+        if (patchRecords(seq, patched)) timer.items(patched);
+        else if (!mayRewrite || !writeSnapshot(files.snapshot, store, slotsInListOrder(), nextId, seq, &layout)) {
+            return false;
+        }
+        dirty.clear();
+        snapshotSequence = seq;
+        // the snapshot is in place either way, and load() skips the records it
+        // contains, but a log that could not be emptied is reported
+        bool emptied = !log.isOpen() || log.truncate();
+        if (!log.failed()) logFailureSeen = false;  // (again) a log worth trusting
+        std::remove(files.foldedLog().c_str());
+        return emptied;
+    }
+
+    // rewrite the records of the dirty tasks in place (patchSnapshot); false,
+    // with the file untouched, if the snapshot needs more than that: a new task,
+    // a new description, or too many removed records to keep
+    bool patchRecords(uint64_t seq, size_t& patched) {
+        if (!layout.isValid()) return false;
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        std::vector<SnapshotPatch> patches;
+        patches.reserve(dirty.size());
+        uint64_t removedAfter = layout.removedCount();
+        for (int id : dirty) {
+            long long record = layout.find(id);
+            TaskNode** found = taskMap.find(id);
+            if (record < 0) {
+                if (found) return false;    // added since the file was written
+                continue;                   // ... and deleted again
+            }
+            SnapshotPatch p = { (uint64_t)record, 1, 0, 1, 0 };
+            if (found) {
+                TaskNode* n = *found;
+                // records are in list order; a task brought back must be between its neighbours' records
+                long long before = n->prev ? layout.find(n->prev->id) : -1;
+                if ((n->prev && before < 0) || before >= record) return false;
+                if (n->next && layout.find(n->next->id) <= record) return false;
+                p.priority = (uint8_t)store.priority(n->slot);
+                p.completed = store.isCompleted(n->slot) ? 1 : 0;
+                p.removed = 0;
+                p.deadline = store.deadline(n->slot);
+            }
+            removedAfter += (uint64_t)p.removed - (uint64_t)layout.isRemoved(p.record);
+            patches.push_back(p);
+        }
+        // deleted tasks' records are dead weight on every load; drop them once there are many
+        if (removedAfter > patchLimit()) return false;
+        if (!patchSnapshot(files.snapshot, layout, patches, nextId, seq)) return false;
+        patched = patches.size();
+        return true;
+    }
+
+    // once the log grows past LOG_COMPACT_BYTES, move it aside and write a
+    // fresh snapshot from a copy of the store on a background thread
+    void maybeCompact() {
+        if (!log.isOpen() || compactor.busy()) return;
+        if (log.bytes() < LOG_COMPACT_BYTES) return;
+        std::error_code ec;
+        if (std::filesystem::exists(files.foldedLog(), ec)) return; // previous fold not finished
+        if (!log.rotate(files.foldedLog())) return;
+        markRewrite();  // the compactor replaces tasks.bin
+        compactor.start(store, slotsInListOrder(), nextId, log.lastSequence(), files.snapshot, files.foldedLog());
+    }
+
+    // the file stays mapped and descriptions point into it until edited;
+    // false if the file is missing or not a valid snapshot
+    bool loadSnapshot(const std::string& path) {
+        if (!snapshotFile.open(path)) return false;
+        SnapshotView view;
+        if (!openSnapshot(snapshotFile, view)) {
+            snapshotFile.close();
+            return false;
+        }
+        if (lazyLoad) snapshotFile.adviseRandom((size_t)(view.blob - snapshotFile.data()));
+
+        size_t n = (size_t)view.count();
+        store.reserve(store.slotCount() + n);
+        taskMap.reserve(taskMap.size() + n);
+        bool skipRemoved = view.header->version >= 3 && (view.header->flags & SNAPSHOT_REMOVED);
+        for (size_t i = 0; i < n; i++) {
+            const SnapshotRecord& r = view.records[i];
+            if (skipRemoved && r.removed) continue;
+            int slot = store.addBorrowed(r.id, view.description(r), r.priority, r.completed != 0);
+            store.setDeadline(slot, view.deadline(i));
+            insertSlot(r.id, slot);
+        }
+        nextId = std::max(nextId, (int)view.header->nextId);
+        snapshotSequence = view.logSequence;
+        layout.assign(view);
+        dirty.clear();
+        return true;
+    }
+
+    // same format exportText() writes; a missing file is not an error.
+    // A lazy load maps the file and borrows the descriptions from it. A
+    // repeated id (the file may be edited by hand) is reported and skipped:
+    // the first task with it is kept.
+    void loadText(const std::string& path, std::vector<ParseError>& errors) {
+        auto repeated = [&](const TextTaskRecord& r) {
+            if (!taskMap.find(r.id)) return false;
+            errors.push_back(ParseError{ r.line, "duplicate task id" });
+            return true;
+        };
+        if (lazyLoad && textFile.open(path)) {
+            parseTaskBuffer(textFile.data(), textFile.size(), [&](const TextTaskRecord& r) {
+                if (repeated(r)) return;
+                int prio = (r.priority < 1 || r.priority > 5) ? 1 : r.priority;
+                int slot = store.addBorrowed(r.id, r.description, prio, r.completed);
+                store.setDeadline(slot, r.deadline);
+                insertSlot(r.id, slot);
+            }, errors);
+            return;
+        }
+        parseTaskFile(path, [&](const TextTaskRecord& r) {
+            if (repeated(r)) return;
+            int prio = (r.priority < 1 || r.priority > 5) ? 1 : r.priority;
+            int slot = store.add(r.id, r.description, prio, r.completed);
+            store.setDeadline(slot, r.deadline);
+            insertSlot(r.id, slot);
+        }, errors);
+    }
+
+    // one log record during startup replay (see task_log.h)
+    void applyLogRecord(const LogRecord& r) {
+        TaskNode** found = taskMap.find(r.id);
+        TaskNode* t = found ? *found : nullptr;
+        switch (r.type) {
+        case LOG_ADD:
+            if (!t) insertTask(r.id, r.description, r.priority, r.completed);
+            markRewrite();
+            break;
+        case LOG_EDIT:
+            if (t) {
+                if (store.description(t->slot) != r.description) markRewrite();
+                else markDirty(r.id);
+                setDescription(t, r.description);
+                store.setPriority(t->slot, r.priority);
+                reschedule(r.id, t->slot);
+            }
+            break;
+        case LOG_DELETE: // the undo history starts empty, so nothing is kept
+            if (t) store.release(detachTask(t));
+            markDirty(r.id);
+            break;
+        case LOG_COMPLETE:
+            if (t) {
+                store.setCompleted(t->slot, r.completed);
+                reschedule(r.id, t->slot);
+            }
+            markDirty(r.id);
+            break;
+        case LOG_DEADLINE:
+            if (t) {
+                store.setDeadline(t->slot, r.deadline);
+                reschedule(r.id, t->slot);
+            }
+            markDirty(r.id);
+            break;
+        case LOG_UNDO:    // the record has every field, the slot was released at delete
+        case LOG_RESTORE: {
+            if (t) break;
+            TaskNode** prev = r.type == LOG_RESTORE && r.after ? taskMap.find(r.after) : nullptr;
+            relinkAfter(makeNode(r.id, r.description, r.priority, r.completed), prev ? *prev : nullptr);
+            markDirty(r.id);    // its record is used again if it is still in the file, in order
+            break;
+        }
+        case LOG_CLEAR_COMPLETED:
+            clearCompleted(false);
+            break;
+        }
+    }
+
+    // free every node and forget every task (and the undo history)
+    void clear() {
+        compactor.wait(); // it may still be writing a snapshot
+        saver.flush();    // and the copies may borrow from the mapped files
+        if constexpr (!NodePolicy::Pool::releasesAll) {
+            for (TaskNode* cur = head; cur;) {
+                TaskNode* next = cur->next;
+                pool.release(cur);
+                cur = next;
+            }
+        }
+        pool.releaseAll();
+        head = tail = nullptr;
+        taskMap.clear();
+        journal.clear();
+        store.clear();
+        textIndex.clear();
+        schedule.clear();
+        markRewrite();
+        snapshotFile.close(); // after the store, which may borrow from them
+        textFile.close();
+        totalTasks = 0;
+    }
+
+    TaskNode* head = nullptr;
+    TaskNode* tail = nullptr;           // last node, so appends don't walk the list
+    typename IndexPolicy::template Map<TaskNode*> taskMap;
+    UndoJournal journal;
+    typename NodePolicy::Pool pool;
+    Store store;
+    TextIndex textIndex;
+    TaskSchedule schedule;
+    MappedFile snapshotFile;            // loaded snapshot; store descriptions may point into it
+    MappedFile textFile;                // tasks.txt after a lazy load, the same
+    bool lazyLoad = false;
+    bool logOnDemand = false;
+    bool logFailureSeen = false;        // the log's failure is reported (and rescueLog() tried)
+    std::vector<std::string> logFailures; // files failedSaves() reports next
+    uint64_t snapshotSequence = 0;      // last log record contained in the loaded snapshot
+    OpLog log;
+    uint64_t cleanSequence = 0;         // last log record after which nothing needs recovering
+    SnapshotLayout layout;              // tasks.bin as last written or loaded; invalid = rewrite it
+    std::vector<int> dirty;             // ids changed since then (may repeat)
+    SnapshotCompactor compactor;        // folds the log into the snapshot in the background
+    AsyncWriter saver;                  // saveInBackground() and autosave
+    std::chrono::seconds autosaveEvery{ 0 };
+    std::chrono::steady_clock::time_point lastAutosave = std::chrono::steady_clock::now();
+    StorageFiles files;
+    int scanThreads = 0;
+    std::unique_ptr<WorkerPool> workers; // started the first time a big scan runs
+    mutable TaskMetrics stats;          // mutable: exportText() is const but timed
+    mutable Mutex mtx;                  // see SyncPolicy
+    int nextId = 1;
+    int totalTasks = 0;
+};
+
+// both programs
+using TaskEngine = BasicTaskEngine<>;
+// small footprint, one thread: no slabs held ahead, no priority lists
+using LeanTaskEngine = BasicTaskEngine<FlatIndex, HeapNodes, SingleThreaded, WithoutPriorityIndex>;
+// one engine shared by several threads (e.g. a server's workers)
+using SharedTaskEngine = BasicTaskEngine<FlatIndex, SlabNodes, Locked, WithPriorityIndex>;
+// one of many lists in one process (task_server.h): nodes from the shared arena
+using HostedTaskEngine = BasicTaskEngine<FlatIndex, ArenaNodes, SingleThreaded, WithPriorityIndex>;
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef TASK_IDMAP_H
+#define TASK_IDMAP_H
+
+/*
+ * FlatIdMap - task id -> value, open addressing in one flat array
+ *
+ * std::unordered_map allocates a node per entry, and every lookup follows a
+ * bucket pointer to it. Here the entries themselves sit in a power-of-two
+ * array and collisions move to the next entry (linear probing), so a lookup
+ * is a multiply, a shift and usually one cache line.
+ *
+ * Ids are hashed by Fibonacci hashing (multiply by 2^32 / golden ratio, keep
+ * the top bits). Consecutive ids, the common case since they come from
+ * nextId, then land spread evenly across the table instead of in one run,
+ * and ids imported from a text file with an odd stride do not pile up either.
+ *
+ * erase() shifts the rest of the probe run back into the hole (no tombstones),
+ * so lookups never slow down after many deletes. The table grows at 3/4 full.
+ *
+ * Pointers returned by find() / operator[] stay valid until the next insert
+ * or erase. Every id except INT_MIN (the empty marker) can be stored.
+ *
+ * StdIdMap has the same interface over std::unordered_map, for the engine
+ * variants that index with it (see task_policy.h) and for comparing the two.
+ */
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+template <class V>
+class FlatIdMap {
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // how many entries fit before the table grows
+    size_t capacity() const { return entries.size() / 4 * 3; }
+
+    // entries / table size (0 before the first insert)
+    double loadFactor() const { return entries.empty() ? 0.0 : (double)count / (double)entries.size(); }
+
+    void clear() {
+        for (Entry& e : entries) e.key = EMPTY;
+        count = 0;
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity()) rehash(tableSizeFor(n));
+    }
+
+    V* find(int id) {
+        if (count == 0) return nullptr;
+        for (size_t i = home(id);; i = (i + 1) & mask) {
+            if (entries[i].key == id) return &entries[i].value;
+            if (entries[i].key == EMPTY) return nullptr;
+        }
+    }
+    const V* find(int id) const { return const_cast<FlatIdMap*>(this)->find(id); }
+
+    bool contains(int id) const { return find(id) != nullptr; }
+
+    // the value for id, default-constructed first if id is new
+    V& operator[](int id) {
+        size_t i = slotFor(id);
+        if (entries[i].key == EMPTY) {
+            entries[i].key = id;
+            entries[i].value = V();
+            count++;
+        }
+        return entries[i].value;
+    }
+
+    // false (and no change) if id is already there, like unordered_map::emplace
+    bool insert(int id, const V& value) {
+        size_t i = slotFor(id);
+        if (entries[i].key != EMPTY) return false;
+        entries[i].key = id;
+        entries[i].value = value;
+        count++;
+        return true;
+    }
+
+    bool erase(int id) {
+        if (count == 0) return false;
+        size_t hole = home(id);
+        while (entries[hole].key != id) {
+            if (entries[hole].key == EMPTY) return false;
+            hole = (hole + 1) & mask;
+        }
+        // pull later entries of the run back, unless that would put one
+        // before its home position
+        for (size_t j = (hole + 1) & mask; entries[j].key != EMPTY; j = (j + 1) & mask) {
+            size_t h = home(entries[j].key);
+            if (((j - h) & mask) >= ((j - hole) & mask)) {
+                entries[hole] = entries[j];
+                hole = j;
+            }
+        }
+        entries[hole].key = EMPTY;
+        count--;
+        return true;
+    }
+
+private:
+    static constexpr int EMPTY = INT_MIN;
+    static constexpr size_t MIN_TABLE = 16;
+
+    struct Entry {
+        int key = EMPTY;
+        V value = V();
+    };
+
+    static size_t tableSizeFor(size_t n) {
+        size_t size = MIN_TABLE;
+        while (size / 4 * 3 < n) size *= 2;
+        return size;
+    }
+
+    size_t home(int id) const {
+        return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    // the entry holding id, or the empty entry where it would go (grows first if needed)
+    size_t slotFor(int id) {
+        if (count + 1 > capacity()) rehash(tableSizeFor(count + 1));
+        size_t i = home(id);
+        while (entries[i].key != id && entries[i].key != EMPTY) i = (i + 1) & mask;
+        return i;
+    }
+
+    void rehash(size_t tableSize) {
+        std::vector<Entry> old;
+        old.swap(entries);
+        entries.resize(tableSize);
+        mask = tableSize - 1;
+        shift = 64;
+        for (size_t s = tableSize; s > 1; s >>= 1) shift--;
+        for (const Entry& e : old) {
+            if (e.key == EMPTY) continue;
+            size_t i = home(e.key);
+            while (entries[i].key != EMPTY) i = (i + 1) & mask;
+            entries[i] = e;
+        }
+    }
+
+    std::vector<Entry> entries;
+    size_t mask = 0;
+    unsigned shift = 64;
+    size_t count = 0;
+};
+
+template <class V>
+class StdIdMap {
+public:
+    size_t size() const { return map.size(); }
+    bool empty() const { return map.empty(); }
+    size_t capacity() const { return (size_t)((double)map.bucket_count() * (double)map.max_load_factor()); }
+    double loadFactor() const { return map.bucket_count() ? map.load_factor() : 0.0; }
+
+    void clear() { map.clear(); }
+    void reserve(size_t n) { map.reserve(n); }
+
+    V* find(int id) {
+        auto it = map.find(id);
+        return it == map.end() ? nullptr : &it->second;
+    }
+    const V* find(int id) const { return const_cast<StdIdMap*>(this)->find(id); }
+    bool contains(int id) const { return map.count(id) != 0; }
+
+    V& operator[](int id) { return map[id]; }
+    bool insert(int id, const V& value) { return map.emplace(id, value).second; }
+    bool erase(int id) { return map.erase(id) != 0; }
+
+private:
+    std::unordered_map<int, V> map;
+};
+
+#endif
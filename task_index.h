@@ -0,0 +1,211 @@
+#ifndef TASK_INDEX_H
+#define TASK_INDEX_H
+
+/*
+ * TextIndex - inverted index over task descriptions
+ *
+ * A token is a run of letters, digits or non-ASCII bytes, lower-cased
+ * (ASCII only). Each token maps to a posting list: the sorted ids of the
+ * tasks whose description contains it, each id once.
+ *
+ * Queries are words separated by spaces, all of which must match (AND):
+ *
+ *   milk store     tasks containing both "milk" and "store"
+ *   groc*          tasks with a token starting with "groc"
+ *
+ * Exact words are intersected first, smallest posting list first, and a
+ * long list is probed with binary searches instead of walked, so a query
+ * costs about the size of its rarest word. A prefix word is then checked
+ * against that candidate set; only a query made of nothing but prefixes
+ * has to merge whole posting lists.
+ *
+ * New ids are appended (posting lists stay sorted for free); restoring an
+ * older id or deleting one is a binary search plus a move within one list.
+ */
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+inline bool isTokenChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// call fn(const std::string& token) for every token of 'text', in order (repeats included)
+template <class Fn>
+void forEachToken(std::string_view text, Fn fn) {
+    std::string token;
+    size_t i = 0, n = text.size();
+    while (i < n) {
+        while (i < n && !isTokenChar((unsigned char)text[i])) i++;
+        if (i == n) break;
+        token.clear();
+        while (i < n && isTokenChar((unsigned char)text[i])) {
+            char c = text[i++];
+            token += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        }
+        fn(token);
+    }
+}
+
+class TextIndex {
+public:
+    // the owner builds the index on first use and keeps it up to date after that
+    bool isBuilt() const { return built; }
+    void markBuilt() { built = true; }
+
+    void clear() {
+        postings.clear();
+        built = false;
+    }
+
+    size_t tokenCount() const { return postings.size(); }
+
+    void add(int id, std::string_view text) {
+        if (!built) return;
+        for (const std::string& t : uniqueTokens(text)) {
+            std::vector<int>& list = postings[t];
+            if (list.empty() || list.back() < id) list.push_back(id);     // the usual case: a new task
+            else {
+                auto it = std::lower_bound(list.begin(), list.end(), id);
+                if (it == list.end() || *it != id) list.insert(it, id);
+            }
+        }
+    }
+
+    void remove(int id, std::string_view text) {
+        if (!built) return;
+        for (const std::string& t : uniqueTokens(text)) {
+            auto p = postings.find(t);
+            if (p == postings.end()) continue;
+            std::vector<int>& list = p->second;
+            auto it = std::lower_bound(list.begin(), list.end(), id);
+            if (it != list.end() && *it == id) list.erase(it);
+            if (list.empty()) postings.erase(p);
+        }
+    }
+
+    // ids (ascending) of the tasks matching every word of 'query'
+    std::vector<int> search(std::string_view query) const {
+        std::vector<const std::vector<int>*> exact;
+        std::vector<std::string> prefixes;
+        bool missing = false;
+        size_t i = 0;
+        while (i < query.size()) {
+            while (i < query.size() && query[i] == ' ') i++;
+            size_t start = i;
+            while (i < query.size() && query[i] != ' ') i++;
+            std::string_view word = query.substr(start, i - start);
+            if (word.empty()) continue;
+            bool prefix = word.back() == '*';
+            if (prefix) word.remove_suffix(1);
+            forEachToken(word, [&](const std::string& t) {
+                if (prefix) {
+                    prefixes.push_back(t);
+                    return;
+                }
+                auto p = postings.find(t);
+                if (p == postings.end()) missing = true;
+                else exact.push_back(&p->second);
+            });
+        }
+        if (missing || (exact.empty() && prefixes.empty())) return std::vector<int>();
+
+        std::vector<int> result;
+        if (!exact.empty()) {
+            std::sort(exact.begin(), exact.end(),
+                      [](const std::vector<int>* a, const std::vector<int>* b) { return a->size() < b->size(); });
+            result = *exact[0];
+            for (size_t k = 1; k < exact.size() && !result.empty(); k++) result = intersect(result, *exact[k]);
+        }
+        for (size_t k = 0; k < prefixes.size(); k++) {
+            if (exact.empty() && k == 0) result = allWithPrefix(prefixes[0]);
+            else result = keepWithPrefix(result, prefixes[k]);
+            if (result.empty()) break;
+        }
+        return result;
+    }
+
+private:
+    // the distinct tokens of a description
+    static std::vector<std::string> uniqueTokens(std::string_view text) {
+        std::vector<std::string> tokens;
+        forEachToken(text, [&](const std::string& t) { tokens.push_back(t); });
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        return tokens;
+    }
+
+    // a is the smaller list; a much longer b is probed by binary search
+    static std::vector<int> intersect(const std::vector<int>& a, const std::vector<int>& b) {
+        std::vector<int> out;
+        if (b.size() > a.size() * 16) {
+            auto from = b.begin();
+            for (int id : a) {
+                from = std::lower_bound(from, b.end(), id);
+                if (from == b.end()) break;
+                if (*from == id) out.push_back(id);
+            }
+        }
+        else {
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        }
+        return out;
+    }
+
+    template <class Fn>
+    void forEachWithPrefix(const std::string& prefix, Fn fn) const {
+        for (auto p = postings.lower_bound(prefix);
+             p != postings.end() && p->first.compare(0, prefix.size(), prefix) == 0; ++p) {
+            fn(p->second);
+        }
+    }
+
+    std::vector<int> allWithPrefix(const std::string& prefix) const {
+        std::vector<int> out;
+        forEachWithPrefix(prefix, [&](const std::vector<int>& list) {
+            out.insert(out.end(), list.begin(), list.end());
+        });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // the candidates that have at least one token starting with 'prefix':
+    // probe each matching list for the candidates, or, when many long lists
+    // match, merge them once and intersect
+    std::vector<int> keepWithPrefix(const std::vector<int>& candidates, const std::string& prefix) const {
+        size_t lists = 0, total = 0;
+        forEachWithPrefix(prefix, [&](const std::vector<int>& list) {
+            lists++;
+            total += list.size();
+        });
+        if (lists == 0) return std::vector<int>();
+        if (lists * candidates.size() > total) {
+            std::vector<int> all = allWithPrefix(prefix);
+            return all.size() < candidates.size() ? intersect(all, candidates) : intersect(candidates, all);
+        }
+
+        std::vector<char> hit(candidates.size(), 0);
+        forEachWithPrefix(prefix, [&](const std::vector<int>& list) {
+            auto from = list.begin();
+            for (size_t k = 0; k < candidates.size(); k++) {
+                from = std::lower_bound(from, list.end(), candidates[k]);
+                if (from == list.end()) break;
+                if (*from == candidates[k]) hit[k] = 1;
+            }
+        });
+        std::vector<int> out;
+        for (size_t k = 0; k < candidates.size(); k++) {
+            if (hit[k]) out.push_back(candidates[k]);
+        }
+        return out;
+    }
+
+    std::map<std::string, std::vector<int>> postings;  // ordered, for prefix ranges
+    bool built = false;
+};
+
+#endif
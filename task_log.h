@@ -0,0 +1,417 @@
+#ifndef TASK_LOG_H
+#define TASK_LOG_H
+
+/*
+ * Append-only operation log (tasks.log)
+ *
+ * Every change to the task list is appended here as it happens, so a crash
+ * loses at most the last few milliseconds of work instead of the session.
+ * At startup the log is replayed on top of the last snapshot; records the
+ * snapshot already contains are skipped by their sequence number.
+ *
+ * Record layout (native byte order):
+ *   u32 length     bytes that follow the 8-byte prefix
+ *   u32 checksum   FNV-1a of those bytes
+ *   u64 sequence   +1 per record, never reused
+ *   u8  type       LogOp
+ *   u32 id
+ *   u8  priority
+ *   u8  completed
+ *   u32 length of the description, then its bytes
+ *   u32 after      LOG_RESTORE only: id of the task before it, 0 = head
+ *   i64 deadline   LOG_DEADLINE only: the new deadline, 0 = none
+ *
+ * Builds from before LOG_SESSION_END read it as a record of an unknown type
+ * and skip it.
+ *
+ * A torn or corrupt record ends the log: replay stops there and the file is
+ * cut back to the last good record so new records are not hidden behind it.
+ *
+ * Group commit: appending only copies the record into a memory buffer. A
+ * background thread writes whatever has piled up and fsyncs once per commit
+ * window (or as soon as a full group is waiting), so many changes share one
+ * fsync. sync() waits until everything appended so far is on disk.
+ *
+ * If a write or fsync fails (disk full, I/O error) the log stops there for
+ * good: nothing more is appended behind what may be a torn record, sync()
+ * returns false and failed() stays true, so the owner writes a snapshot
+ * instead of trusting the log. truncate() after that snapshot starts the log
+ * afresh.
+ *
+ * SnapshotCompactor writes a snapshot on a background thread, so the log can
+ * be folded into tasks.bin without stalling the menu.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "task_snapshot.h"
+#include "task_store.h"
+
+enum LogOp : uint8_t {
+    LOG_ADD = 1,            // id, priority, completed, description
+    LOG_EDIT = 2,           // id, priority, description (the new values)
+    LOG_DELETE = 3,         // id
+    LOG_COMPLETE = 4,       // id, completed
+    LOG_UNDO = 5,           // id, priority, completed, description; put back at the head
+                            // (older logs only, LOG_RESTORE replaced it)
+    LOG_CLEAR_COMPLETED = 6,// no fields
+    LOG_RESTORE = 7,        // like LOG_UNDO, plus after: put back behind that task
+    LOG_DEADLINE = 8,       // id, deadline
+    LOG_SESSION_END = 9     // no fields; a session ended cleanly and kept the log (lazy load),
+                            // so the records before it are not a crash's leftovers
+};
+
+struct LogRecord {
+    uint64_t sequence;
+    uint8_t type;
+    int id;
+    int priority;
+    bool completed;
+    std::string_view description;   // valid only during the replay callback
+    int after = 0;                  // LOG_RESTORE
+    int64_t deadline = 0;           // LOG_DEADLINE
+};
+
+inline uint32_t fnv1a(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ================================
+// Writer with group commit
+// ================================
+class OpLog {
+public:
+    static constexpr size_t GROUP_SIZE = 256;     // flush early once this many records wait
+    static constexpr int COMMIT_WINDOW_MS = 5;    // otherwise flush this long after the first one
+
+    OpLog() {}
+    ~OpLog() { close(); }
+    OpLog(const OpLog&) = delete;
+    OpLog& operator=(const OpLog&) = delete;
+
+    // open (or create) the log for appending; the next record gets 'nextSequence'.
+    // onDemand: the file is not touched (nor the flusher started) until the
+    // first record, so a log nobody writes to costs no file and no thread.
+    bool open(const std::string& logPath, uint64_t nextSequence, bool onDemand = false) {
+        close();
+        path = logPath;
+        nextSeq = nextSequence;
+        appendedSeq = durableSeq = nextSequence - 1;
+        std::error_code ec;
+        fileBytes = std::filesystem::file_size(path, ec);
+        if (ec) fileBytes = 0;
+        active = onDemand || start();
+        return active;
+    }
+
+    // flush everything and stop the background thread
+    void close() {
+        release();
+        active = false;
+    }
+
+    // close() but stay open: the next record opens the file again. For a log
+    // that has gone quiet, so it holds no descriptor or thread meanwhile.
+    void release() {
+        if (!file) return;
+        sync();
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        flusher.join();
+        fclose(file);
+        file = nullptr;
+    }
+
+    bool isOpen() const { return active; }
+    bool failed() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return writeFailed;
+    }
+    uint64_t lastSequence() const { return nextSeq - 1; }
+    uint64_t bytes() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return fileBytes + pending.size();
+    }
+
+    void add(int id, std::string_view desc, int priority, bool completed) { record(LOG_ADD, id, priority, completed, desc); }
+    void edit(int id, std::string_view desc, int priority) { record(LOG_EDIT, id, priority, false, desc); }
+    void remove(int id) { record(LOG_DELETE, id, 0, false, std::string_view()); }
+    void complete(int id, bool done) { record(LOG_COMPLETE, id, 0, done, std::string_view()); }
+    void restore(int id, std::string_view desc, int priority, bool completed, int after) {
+        record(LOG_RESTORE, id, priority, completed, desc, &after, sizeof(after));
+    }
+    void deadline(int id, int64_t when) { record(LOG_DEADLINE, id, 0, false, std::string_view(), &when, sizeof(when)); }
+    void clearCompleted() { record(LOG_CLEAR_COMPLETED, 0, 0, false, std::string_view()); }
+    void endSession() { record(LOG_SESSION_END, 0, 0, false, std::string_view()); }
+
+    // block until every record appended so far is written and fsynced;
+    // false if the log has failed (see above), some of them may not be
+    bool sync() {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!file || writeFailed) return !writeFailed;
+        uint64_t target = appendedSeq;
+        syncRequested = true;
+        cv.notify_all();
+        flushedCv.wait(lk, [&] { return durableSeq >= target || writeFailed; });
+        syncRequested = false;
+        return !writeFailed;
+    }
+
+    // move the current log to 'newPath' and carry on in a new, empty file.
+    // False if either step fails; the log then carries on in the file it had.
+    bool rotate(const std::string& newPath) {
+        if (!file || !sync()) return false;
+        std::lock_guard<std::mutex> io(ioMtx);
+        std::error_code ec;
+        std::filesystem::rename(path, newPath, ec);
+        if (ec) return false;
+        FILE* fresh = fopen(path.c_str(), "wb");
+        if (!fresh) {
+            std::filesystem::rename(newPath, path, ec);   // the open file is still the one moved
+            return false;
+        }
+        fclose(file);
+        file = fresh;
+        std::lock_guard<std::mutex> lk(mtx);
+        fileBytes = 0;
+        return true;
+    }
+
+    // throw away every record (a snapshot now contains them); false, with
+    // the records kept, if the file cannot be reopened empty. A failed log
+    // carries on from the empty file.
+    bool truncate() {
+        if (!active) return false;
+        if (!file) {    // released or not written yet: empty what is on disk, if anything
+            std::error_code ec;
+            if (std::filesystem::exists(path, ec)) std::filesystem::resize_file(path, 0, ec);
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!ec) restart();
+            return !ec;
+        }
+        sync();     // even if it fails: the snapshot has every record
+        std::lock_guard<std::mutex> io(ioMtx);
+        FILE* fresh = fopen(path.c_str(), "wb");   // the old one stays open until this worked
+        if (!fresh) return false;
+        fclose(file);
+        file = fresh;
+        std::lock_guard<std::mutex> lk(mtx);
+        restart();
+        return true;
+    }
+
+private:
+    void put32(uint32_t v) { pending.append((const char*)&v, 4); }
+
+    // the file is empty again: records not written yet are in the snapshot too
+    void restart() {
+        pending.clear();
+        pendingRecords = 0;
+        durableSeq = appendedSeq;
+        fileBytes = 0;
+        writeFailed = false;
+    }
+
+    bool start() {
+        file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+        stopping = false;
+        flusher = std::thread(&OpLog::flusherLoop, this);
+        return true;
+    }
+
+    // 'extra' is the type's fixed trailer (see the layout above)
+    void record(uint8_t type, int id, int priority, bool completed, std::string_view desc,
+                const void* extra = nullptr, size_t extraSize = 0) {
+        if (!active) return;
+        // (re)opening failed: stop logging rather than leave a gap; the file
+        // so far is a consistent prefix and the next checkpoint covers the rest
+        if (!file && !(active = start())) return;
+        std::lock_guard<std::mutex> lk(mtx);
+        if (writeFailed) return;    // the same: nothing behind a torn record
+        size_t start = pending.size();
+        put32(0);   // length and checksum, filled in below
+        put32(0);
+        uint64_t seq = nextSeq++;
+        pending.append((const char*)&seq, 8);
+        pending.push_back((char)type);
+        put32((uint32_t)id);
+        pending.push_back((char)priority);
+        pending.push_back(completed ? 1 : 0);
+        put32((uint32_t)desc.size());
+        pending.append(desc.data(), desc.size());
+        pending.append((const char*)extra, extraSize);
+
+        uint32_t length = (uint32_t)(pending.size() - start - 8);
+        uint32_t sum = fnv1a(pending.data() + start + 8, length);
+        memcpy(&pending[start], &length, 4);
+        memcpy(&pending[start + 4], &sum, 4);
+        appendedSeq = seq;
+        if (++pendingRecords == 1 || pendingRecords >= GROUP_SIZE) cv.notify_all();
+    }
+
+    void flusherLoop() {
+        std::unique_lock<std::mutex> lk(mtx);
+        while (true) {
+            cv.wait(lk, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break;     // stopping, nothing left
+            // let a group build up unless someone is waiting for it
+            cv.wait_for(lk, std::chrono::milliseconds(COMMIT_WINDOW_MS), [&] {
+                return stopping || syncRequested || pendingRecords >= GROUP_SIZE;
+            });
+
+            std::string batch;
+            batch.swap(pending);
+            uint64_t upto = appendedSeq;
+            pendingRecords = 0;
+            bool write = !writeFailed, ok = false;  // after a failure the batch is dropped
+            lk.unlock();
+            if (write) {
+                std::lock_guard<std::mutex> io(ioMtx);
+                ok = fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+                ok = (fflush(file) == 0) && ok;
+#ifdef _WIN32
+                ok = ok && _commit(_fileno(file)) == 0;
+#else
+                ok = ok && fdatasync(fileno(file)) == 0;
+#endif
+            }
+            lk.lock();
+            if (ok) {
+                fileBytes += batch.size();
+                durableSeq = upto;
+            }
+            else if (write) writeFailed = true;    // the batch may be half written: stop here
+            flushedCv.notify_all();
+        }
+    }
+
+    std::string path;
+    FILE* file = nullptr;       // null while open on demand or released
+    bool active = false;        // open() succeeded and close() has not been called
+    std::thread flusher;
+    std::mutex mtx;             // guards everything below
+    std::mutex ioMtx;           // guards the file itself
+    std::condition_variable cv, flushedCv;
+    std::string pending;        // encoded records not written yet
+    size_t pendingRecords = 0;
+    uint64_t nextSeq = 1, appendedSeq = 0, durableSeq = 0;
+    uint64_t fileBytes = 0;     // bytes already in the file
+    bool stopping = false, syncRequested = false;
+    bool writeFailed = false;   // a write or fsync failed; see the top of the file
+};
+
+// ================================
+// Replay: call fn(const LogRecord&) for each good record with sequence > afterSeq.
+// A damaged tail is cut off. Returns the number of records passed to fn;
+// lastSeq is raised to the highest sequence seen.
+// ================================
+template <class Fn>
+size_t replayOpLog(const std::string& path, uint64_t afterSeq, Fn fn, uint64_t& lastSeq) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    std::string buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    const size_t fixed = 8 + 1 + 4 + 1 + 1 + 4;   // sequence .. description length
+    size_t pos = 0, applied = 0;
+    while (buf.size() - pos >= 8) {
+        uint32_t length, sum;
+        memcpy(&length, &buf[pos], 4);
+        memcpy(&sum, &buf[pos + 4], 4);
+        if (length < fixed || length > buf.size() - pos - 8) break;
+        const char* p = buf.data() + pos + 8;
+        if (fnv1a(p, length) != sum) break;
+
+        LogRecord r;
+        uint32_t id, descLen;
+        memcpy(&r.sequence, p, 8);
+        r.type = (uint8_t)p[8];
+        memcpy(&id, p + 9, 4);
+        r.id = (int)id;
+        r.priority = (unsigned char)p[13];
+        r.completed = p[14] != 0;
+        memcpy(&descLen, p + 15, 4);
+        size_t trailer = r.type == LOG_RESTORE ? 4 : r.type == LOG_DEADLINE ? 8 : 0;
+        if ((size_t)descLen + trailer != length - fixed) break;
+        r.description = std::string_view(p + fixed, descLen);
+        if (r.type == LOG_RESTORE) {
+            uint32_t after;
+            memcpy(&after, p + fixed + descLen, 4);
+            r.after = (int)after;
+        } else if (r.type == LOG_DEADLINE) {
+            memcpy(&r.deadline, p + fixed + descLen, 8);
+        }
+
+        if (r.sequence > lastSeq) lastSeq = r.sequence;
+        if (r.sequence > afterSeq) {
+            fn(r);
+            applied++;
+        }
+        pos += 8 + length;
+    }
+    if (pos < buf.size()) {
+        std::error_code ec;
+        std::filesystem::resize_file(path, pos, ec);
+    }
+    return applied;
+}
+
+// ================================
+// Background snapshot writer (log compaction)
+// ================================
+class SnapshotCompactor {
+public:
+    ~SnapshotCompactor() { wait(); }
+
+    bool busy() const { return running; }
+
+    // write 'store' (slots in 'order') to snapshotPath on a background thread,
+    // then delete 'foldedLog', whose records the snapshot now contains
+    template <class Store>
+    void start(Store store, std::vector<int> order, int nextId, uint64_t logSequence,
+               const std::string& snapshotPath, const std::string& foldedLog) {
+        wait();
+        running = true;
+        worker = std::thread([=, s = std::move(store), o = std::move(order)] {
+            if (writeSnapshot(snapshotPath, s, o, nextId, logSequence)) {
+                std::remove(foldedLog.c_str());
+            }
+            running = false;
+        });
+    }
+
+    void wait() {
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    std::thread worker;
+    std::atomic<bool> running{ false };
+};
+
+#endif
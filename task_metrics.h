@@ -0,0 +1,298 @@
+#ifndef TASK_METRICS_H
+#define TASK_METRICS_H
+
+/*
+ * TaskMetrics - operation counters and latency histograms
+ *
+ * Per operation kind (add, delete, scan, load, ...):
+ *
+ *   calls    how many times it ran
+ *   items    tasks it touched (a bulk delete of 500 ids is 1 call, 500 items)
+ *   latency  histogram of call durations in power-of-two buckets of
+ *            nanoseconds (bucket i counts calls taking up to 2^i ns), plus
+ *            their sum, so p50/p99 are known to a factor of two
+ *
+ * Calls and items are exact. Only one call in TASK_METRICS_SAMPLE (and
+ * always the first) is timed: a clock read costs about as much as marking a
+ * task done, so timing every call would double the cost of the cheap ones.
+ * The histogram and the sum cover the timed calls. -DTASK_METRICS_SAMPLE=1
+ * times every call.
+ *
+ * The engine is single-threaded, so nothing is atomic. Build with
+ * -DTASK_METRICS=0 to compile it all out: TaskMetrics and MetricTimer are then
+ * empty and every call is a no-op.
+ *
+ * Gauges (list length, store slots, map load factor, ...) are not kept here;
+ * the owner fills a MetricGauges when asked, so they cost nothing in between
+ * and are there even with metrics compiled out.
+ *
+ * writeStatsTable() prints both for people, writePrometheus() in the
+ * Prometheus text format and writeMetricsJson() as one JSON object.
+ */
+
+#ifndef TASK_METRICS
+#define TASK_METRICS 1
+#endif
+#ifndef TASK_METRICS_SAMPLE
+#define TASK_METRICS_SAMPLE 16
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+enum MetricOp {
+    OP_ADD,
+    OP_EDIT,
+    OP_COMPLETE,
+    OP_DELETE,
+    OP_CLEAR,
+    OP_UNDO,
+    OP_REDO,
+    OP_SEARCH,
+    OP_SCAN,        // filtering the store's columns
+    OP_LIST,        // printing a listing
+    OP_COMPACT,     // store compaction
+    OP_LOAD,
+    OP_SAVE,        // snapshot checkpoint
+    OP_EXPORT,      // text file
+    OP_NEXT,        // next task from the schedule
+    OP_DEADLINE,    // setting or clearing a deadline
+    OP_KINDS
+};
+
+inline const char* metricOpName(int op) {
+    static const char* names[OP_KINDS] = { "add", "edit", "complete", "delete", "clear", "undo", "redo",
+                                           "search", "scan", "list", "compact", "load", "save", "export",
+                                           "next", "deadline" };
+    return names[op];
+}
+
+struct MetricGauges {
+    long long tasks = 0;            // in the list
+    long long storeSlots = 0;       // including hidden and released ones
+    long long freedSlots = 0;       // released, waiting for compaction
+    long long mapEntries = 0;
+    double mapLoadFactor = 0;       // entries / table size
+    long long undoBytes = 0;        // estimated memory held by the undo history
+    long long logBytes = 0;         // tasks.log size since the last checkpoint
+    long long indexTokens = 0;      // distinct words in the text index (0 until the first search)
+};
+
+#if TASK_METRICS
+
+class TaskMetrics {
+public:
+    static constexpr bool enabled = true;
+    static constexpr int BUCKETS = 40;      // up to 2^39 ns, about 9 minutes
+    static constexpr uint64_t SAMPLE = TASK_METRICS_SAMPLE > 0 ? TASK_METRICS_SAMPLE : 1;
+
+    struct OpStats {
+        uint64_t calls = 0;
+        uint64_t items = 0;
+        uint64_t timed = 0;         // calls in the histogram
+        uint64_t totalNs = 0;       // of the timed calls
+        uint64_t buckets[BUCKETS] = {};
+    };
+
+    // whether the next call of 'op' should be timed
+    bool timeNext(MetricOp op) const { return ops[op].calls % SAMPLE == 0; }
+
+    void record(MetricOp op, uint64_t items) {
+        OpStats& s = ops[op];
+        s.calls++;
+        s.items += items;
+    }
+
+    void recordTimed(MetricOp op, uint64_t items, uint64_t ns) {
+        record(op, items);
+        OpStats& s = ops[op];
+        s.timed++;
+        s.totalNs += ns;
+        s.buckets[bucketFor(ns)]++;
+    }
+
+    const OpStats& stats(int op) const { return ops[op]; }
+    void reset() { *this = TaskMetrics(); }
+
+    // upper bound of the bucket holding quantile q (0..1) of the timed calls, in ns
+    uint64_t percentileNs(int op, double q) const {
+        const OpStats& s = ops[op];
+        if (s.timed == 0) return 0;
+        uint64_t want = (uint64_t)std::ceil(q * (double)s.timed);
+        if (want == 0) want = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += s.buckets[b];
+            if (seen >= want) return bucketLimitNs(b);
+        }
+        return bucketLimitNs(BUCKETS - 1);
+    }
+
+    static uint64_t bucketLimitNs(int b) { return (uint64_t)1 << b; }
+
+private:
+    // smallest b with ns <= 2^b: the bit length of ns - 1
+    static int bucketFor(uint64_t ns) {
+        if (ns <= 1) return 0;
+#if defined(__GNUC__)
+        int b = 64 - __builtin_clzll(ns - 1);
+#else
+        int b = 0;
+        while (bucketLimitNs(b) < ns) b++;
+#endif
+        return b < BUCKETS ? b : BUCKETS - 1;
+    }
+
+    OpStats ops[OP_KINDS];
+};
+
+// counts one call, and times it from construction to destruction if it is sampled
+class MetricTimer {
+public:
+    MetricTimer(TaskMetrics& metrics, MetricOp op) : metrics(metrics), op(op), timed(metrics.timeNext(op)) {
+        if (timed) start = std::chrono::steady_clock::now();
+    }
+    ~MetricTimer() {
+        if (!timed) {
+            metrics.record(op, itemCount);
+            return;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        metrics.recordTimed(op, itemCount, (uint64_t)ns.count());
+    }
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+    void items(uint64_t n) { itemCount = n; }
+
+private:
+    TaskMetrics& metrics;
+    MetricOp op;
+    bool timed;
+    std::chrono::steady_clock::time_point start;
+    uint64_t itemCount = 1;
+};
+
+#else
+
+class TaskMetrics {
+public:
+    static constexpr bool enabled = false;
+    void record(MetricOp, uint64_t) {}
+    void reset() {}
+};
+
+class MetricTimer {
+public:
+    MetricTimer(TaskMetrics&, MetricOp) {}
+    void items(uint64_t) {}
+};
+
+#endif
+
+// ---- output ----
+
+inline std::string metricNumber(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+// for people: one row per operation that ran, then the gauges
+inline void writeStatsTable(std::ostream& out, const TaskMetrics& metrics, const MetricGauges& g) {
+    out << "\n=== Performance Stats ===\n";
+#if TASK_METRICS
+    out << "operation      calls      items      timed    avg us    p50 us    p99 us\n";
+    for (int op = 0; op < OP_KINDS; op++) {
+        const TaskMetrics::OpStats& s = metrics.stats(op);
+        if (s.calls == 0) continue;
+        char row[128];
+        std::snprintf(row, sizeof(row), "%-10s %9llu  %9llu  %9llu  %8.2f  %8.2f  %8.2f\n", metricOpName(op),
+                      (unsigned long long)s.calls, (unsigned long long)s.items, (unsigned long long)s.timed,
+                      s.timed ? (double)s.totalNs / (double)s.timed / 1000.0 : 0.0, metrics.percentileNs(op, 0.50) / 1000.0,
+                      metrics.percentileNs(op, 0.99) / 1000.0);
+        out << row;
+    }
+    out << "(1 call in " << TaskMetrics::SAMPLE << " is timed; percentiles are bucket upper bounds, within 2x)\n";
+#else
+    (void)metrics;
+    out << "operation metrics are compiled out (build with -DTASK_METRICS=1)\n";
+#endif
+    out << "tasks: " << g.tasks << ", store slots: " << g.storeSlots << " (" << g.freedSlots << " freed)"
+        << ", map load: " << metricNumber(g.mapLoadFactor) << "\n";
+    out << "undo history: " << g.undoBytes << " bytes, log: " << g.logBytes << " bytes, index words: "
+        << g.indexTokens << "\n";
+    out << "=========================\n";
+}
+
+// Prometheus text exposition format, names prefixed todo_
+inline void writePrometheus(std::ostream& out, const TaskMetrics& metrics, const MetricGauges& g) {
+#if TASK_METRICS
+    out << "# HELP todo_op_calls_total Operations run.\n# TYPE todo_op_calls_total counter\n";
+    for (int op = 0; op < OP_KINDS; op++) {
+        out << "todo_op_calls_total{op=\"" << metricOpName(op) << "\"} " << metrics.stats(op).calls << "\n";
+    }
+    out << "# HELP todo_op_items_total Tasks touched by operations.\n# TYPE todo_op_items_total counter\n";
+    for (int op = 0; op < OP_KINDS; op++) {
+        out << "todo_op_items_total{op=\"" << metricOpName(op) << "\"} " << metrics.stats(op).items << "\n";
+    }
+    out << "# HELP todo_op_duration_seconds Latency of the timed (sampled) calls.\n"
+           "# TYPE todo_op_duration_seconds histogram\n";
+    for (int op = 0; op < OP_KINDS; op++) {
+        const TaskMetrics::OpStats& s = metrics.stats(op);
+        int last = TaskMetrics::BUCKETS - 1;
+        while (last > 0 && s.buckets[last] == 0) last--;
+        uint64_t cumulative = 0;
+        for (int b = 0; b <= last; b++) {
+            cumulative += s.buckets[b];
+            out << "todo_op_duration_seconds_bucket{op=\"" << metricOpName(op) << "\",le=\""
+                << metricNumber(TaskMetrics::bucketLimitNs(b) / 1e9) << "\"} " << cumulative << "\n";
+        }
+        out << "todo_op_duration_seconds_bucket{op=\"" << metricOpName(op) << "\",le=\"+Inf\"} " << s.timed << "\n";
+        out << "todo_op_duration_seconds_sum{op=\"" << metricOpName(op) << "\"} " << metricNumber(s.totalNs / 1e9) << "\n";
+        out << "todo_op_duration_seconds_count{op=\"" << metricOpName(op) << "\"} " << s.timed << "\n";
+    }
+#else
+    (void)metrics;
+#endif
+    auto gauge = [&](const char* name, const char* help, const std::string& value) {
+        out << "# HELP todo_" << name << " " << help << "\n# TYPE todo_" << name << " gauge\n";
+        out << "todo_" << name << " " << value << "\n";
+    };
+    gauge("tasks", "Tasks in the list.", std::to_string(g.tasks));
+    gauge("store_slots", "Store slots, including hidden and freed ones.", std::to_string(g.storeSlots));
+    gauge("store_freed_slots", "Freed store slots waiting for compaction.", std::to_string(g.freedSlots));
+    gauge("map_entries", "Entries in the id map.", std::to_string(g.mapEntries));
+    gauge("map_load_factor", "Id map entries per table slot.", metricNumber(g.mapLoadFactor));
+    gauge("undo_bytes", "Estimated memory held by the undo history.", std::to_string(g.undoBytes));
+    gauge("log_bytes", "Bytes in tasks.log since the last checkpoint.", std::to_string(g.logBytes));
+    gauge("index_tokens", "Distinct words in the text index.", std::to_string(g.indexTokens));
+}
+
+// {"enabled":..,"sample":..,"ops":{"add":{"calls":..,"items":..,"timed":..,"total_ns":..,"p50_ns":..,"p99_ns":..},...},
+//  "gauges":{...}}
+inline void writeMetricsJson(std::ostream& out, const TaskMetrics& metrics, const MetricGauges& g) {
+    out << "{\"enabled\":" << (TaskMetrics::enabled ? "true" : "false");
+#if TASK_METRICS
+    out << ",\"sample\":" << TaskMetrics::SAMPLE << ",\"ops\":{";
+    for (int op = 0; op < OP_KINDS; op++) {
+        const TaskMetrics::OpStats& s = metrics.stats(op);
+        out << (op ? "," : "") << "\"" << metricOpName(op) << "\":{\"calls\":" << s.calls << ",\"items\":" << s.items
+            << ",\"timed\":" << s.timed << ",\"total_ns\":" << s.totalNs << ",\"p50_ns\":" << metrics.percentileNs(op, 0.50)
+            << ",\"p99_ns\":" << metrics.percentileNs(op, 0.99) << "}";
+    }
+#else
+    (void)metrics;
+    out << ",\"ops\":{";
+#endif
+    out << "},\"gauges\":{\"tasks\":" << g.tasks << ",\"store_slots\":" << g.storeSlots
+        << ",\"store_freed_slots\":" << g.freedSlots << ",\"map_entries\":" << g.mapEntries
+        << ",\"map_load_factor\":" << metricNumber(g.mapLoadFactor) << ",\"undo_bytes\":" << g.undoBytes
+        << ",\"log_bytes\":" << g.logBytes << ",\"index_tokens\":" << g.indexTokens << "}}\n";
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef TASK_PAGE_H
+#define TASK_PAGE_H
+
+/*
+ * Paging through the task list without walking it
+ *
+ * A page is positions [first, first + size) of a view: every task, the
+ * pending or the completed ones, one priority, or every task by priority
+ * (priority 1 first, each priority in list order, like the priority listing).
+ *
+ * SlotRanks makes that O(log n + size). The store's slots are cut into
+ * blocks of 64, and a Fenwick tree over the blocks keeps how many live,
+ * completed and per-priority tasks each block holds. Finding position k of a
+ * view is one descent of the tree and a scan of one block's flag bytes; so is
+ * the opposite, counting how many tasks of a view come before a slot. The
+ * rest of a page follows from there: through the priority lists, or forward
+ * through the block and, past its end, one more descent.
+ *
+ * Counting is what makes the cursor stable: the next page starts right after
+ * the last task shown, wherever that task is now, so tasks added or deleted
+ * in front of it do not shift what the next page shows.
+ *
+ * The tree is built the first time a page is asked for (O(n)) and kept up to
+ * date by the store's mutators from then on, O(log n) per change; until then
+ * they pay one branch. Slots are in list order (see task_store.h), which is
+ * what lets a slot range stand for a stretch of the list.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// what SlotRanks counts per block
+enum RankKind {
+    RANK_LIVE,
+    RANK_DONE,          // live and completed
+    RANK_PRIORITY,      // + (priority - 1): live tasks of that priority
+    RANK_KINDS = RANK_PRIORITY + 5
+};
+
+class SlotRanks {
+public:
+    static constexpr int BLOCK = 64;
+    using Counts = std::array<int, RANK_KINDS>;
+
+    bool isBuilt() const { return built; }
+    bool covers(int slot) const { return (size_t)(slot / BLOCK) < tree.size(); }
+    size_t bytes() const { return tree.capacity() * sizeof(Counts); }
+
+    void clear() {
+        std::vector<Counts>().swap(tree);
+        built = false;
+    }
+
+    // start over for slots [0, slotCount), with room to grow;
+    // kinds(slot, Counts&) adds one slot's kinds to the counts
+    template <class Kinds>
+    void build(int slotCount, Kinds kinds) {
+        size_t blocks = 1;
+        while (blocks * BLOCK <= (size_t)slotCount) blocks *= 2;
+        tree.assign(blocks, Counts{});
+        for (int s = 0; s < slotCount; s++) kinds(s, tree[(size_t)s / BLOCK]);
+        // block totals -> Fenwick tree, O(blocks)
+        for (size_t i = 1; i <= blocks; i++) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent > blocks) continue;
+            for (int k = 0; k < RANK_KINDS; k++) tree[parent - 1][k] += tree[i - 1][k];
+        }
+        built = true;
+    }
+
+    void add(int slot, int kind, int delta) {
+        for (size_t i = (size_t)slot / BLOCK + 1; i <= tree.size(); i += i & (~i + 1)) tree[i - 1][kind] += delta;
+    }
+
+    // totals of blocks [0, block)
+    Counts before(size_t block) const {
+        Counts c{};
+        for (size_t i = block; i > 0; i -= i & (~i + 1)) {
+            for (int k = 0; k < RANK_KINDS; k++) c[k] += tree[i - 1][k];
+        }
+        return c;
+    }
+
+    // the block holding item k (0-based) when every block counts weight(Counts)
+    // items (weight must add up, e.g. live - done); 'skipped' gets the items in
+    // the blocks before it. Returns a block past the end if there are not k + 1 items.
+    template <class Weight>
+    size_t findBlock(long long k, Weight weight, long long& skipped) const {
+        size_t pos = 0;
+        skipped = 0;
+        for (size_t step = tree.size(); step > 0; step >>= 1) {
+            if (pos + step > tree.size()) continue;
+            long long w = weight(tree[pos + step - 1]);
+            if (skipped + w <= k) {
+                pos += step;
+                skipped += w;
+            }
+        }
+        return pos;
+    }
+
+private:
+    std::vector<Counts> tree;   // Fenwick tree over the blocks, 1-based in the usual way
+    bool built = false;
+};
+
+// ================================
+// Views and pages
+// ================================
+enum class PageView : uint8_t { All, Pending, Completed, Priority, ByPriority };
+
+struct TaskPage {
+    PageView view = PageView::All;
+    int priority = 0;           // PageView::Priority: which one
+    size_t size = 20;           // tasks per page
+    size_t first = 0;           // view position of the first task shown (0-based)
+    size_t total = 0;           // tasks in the view when the page was taken
+    std::vector<int> slots;     // the tasks, in view order; valid until the next change
+    int firstId = 0, lastId = 0;                // where prev / next continue from
+    int firstPriority = 0, lastPriority = 0;    // their priorities then (ByPriority)
+
+    size_t number() const { return size ? first / size + 1 : 1; }     // 1-based
+    size_t pages() const { return size && total ? (total + size - 1) / size : 1; }
+    bool atStart() const { return first == 0; }
+    bool atEnd() const { return first + slots.size() >= total; }
+};
+
+// "all", "pending", "completed", "priority" (by priority) or "p1".."p5"
+inline bool parseView(std::string_view word, PageView& view, int& priority) {
+    priority = 0;
+    if (word == "all") view = PageView::All;
+    else if (word == "pending") view = PageView::Pending;
+    else if (word == "completed") view = PageView::Completed;
+    else if (word == "priority") view = PageView::ByPriority;
+    else if (word.size() == 2 && word[0] == 'p' && word[1] >= '1' && word[1] <= '5') {
+        view = PageView::Priority;
+        priority = word[1] - '0';
+    }
+    else return false;
+    return true;
+}
+
+inline std::string viewTitle(PageView view, int priority) {
+    switch (view) {
+    case PageView::All: return "All Tasks";
+    case PageView::Pending: return "Pending Tasks";
+    case PageView::Completed: return "Completed Tasks";
+    case PageView::Priority: return "Priority " + std::to_string(priority) + " Tasks";
+    case PageView::ByPriority: return "Tasks by Priority";
+    }
+    return "Tasks";
+}
+
+// one flat view (everything but ByPriority, which is five Priority views in a row)
+// as SlotRanks counts it and as a slot test
+struct RankFilter {
+    PageView view;
+    int priority;
+
+    long long weight(const SlotRanks::Counts& c) const {
+        switch (view) {
+        case PageView::Pending: return c[RANK_LIVE] - c[RANK_DONE];
+        case PageView::Completed: return c[RANK_DONE];
+        case PageView::Priority: return c[RANK_PRIORITY + priority - 1];
+        default: return c[RANK_LIVE];
+        }
+    }
+
+    template <class Store>
+    bool matches(const Store& st, int slot) const {
+        unsigned char f = st.flags[(size_t)slot];
+        switch (view) {
+        case PageView::Pending: return f == Store::LIVE;
+        case PageView::Completed: return f == (Store::LIVE | Store::DONE);
+        case PageView::Priority: return (f & Store::LIVE) && st.priorities[(size_t)slot] == priority;
+        default: return (f & Store::LIVE) != 0;
+        }
+    }
+};
+
+// tasks of the view in slots [0, slot); the store's ranks must be built
+template <class Store>
+long long countBefore(const Store& st, RankFilter filter, int slot) {
+    size_t block = (size_t)slot / SlotRanks::BLOCK;
+    long long n = filter.weight(st.ranks.before(block));
+    for (int s = (int)(block * SlotRanks::BLOCK); s < slot; s++) n += filter.matches(st, s);
+    return n;
+}
+
+// slot of the view's k-th task (0-based), -1 if it has fewer
+template <class Store>
+int selectSlot(const Store& st, RankFilter filter, long long k) {
+    long long skipped;
+    size_t block = st.ranks.findBlock(k, [&](const SlotRanks::Counts& c) { return filter.weight(c); }, skipped);
+    int end = std::min(st.slotCount(), (int)((block + 1) * SlotRanks::BLOCK));
+    for (int s = (int)(block * SlotRanks::BLOCK); s < end; s++) {
+        if (filter.matches(st, s) && skipped++ == k) return s;
+    }
+    return -1;
+}
+
+// the view's next slot after 'slot', -1 at the end
+template <class Store>
+int nextSlot(const Store& st, RankFilter filter, int slot) {
+    if constexpr (Store::hasPriorityLists) {
+        if (filter.view == PageView::Priority) return st.prioNext[(size_t)slot];
+    }
+    int end = std::min(st.slotCount(), (slot / SlotRanks::BLOCK + 1) * SlotRanks::BLOCK);
+    for (int s = slot + 1; s < end; s++) {
+        if (filter.matches(st, s)) return s;
+    }
+    return end < st.slotCount() ? selectSlot(st, filter, countBefore(st, filter, end)) : -1;
+}
+
+template <class Store>
+size_t viewSize(const Store& st, PageView view, int priority) {
+    switch (view) {
+    case PageView::Pending: return (size_t)(st.liveCount - st.doneCount);
+    case PageView::Completed: return (size_t)st.doneCount;
+    case PageView::Priority: return (size_t)st.prioLive[priority];
+    default: return (size_t)st.liveCount;
+    }
+}
+
+// tasks of the view in front of the one at (priority, slot); the priority only
+// matters for ByPriority, where it picks the bucket
+template <class Store>
+size_t positionBefore(const Store& st, PageView view, int viewPriority, int priority, int slot) {
+    if (view != PageView::ByPriority) return (size_t)countBefore(st, RankFilter{ view, viewPriority }, slot);
+    size_t n = 0;
+    for (int p = 1; p < priority; p++) n += (size_t)st.prioLive[p];
+    return n + (size_t)countBefore(st, RankFilter{ PageView::Priority, priority }, slot);
+}
+
+// fill page.slots (and total / anchors) from position page.first on
+template <class Store>
+void fillPage(const Store& st, TaskPage& page) {
+    page.slots.clear();
+    page.total = viewSize(st, page.view, page.priority);
+    if (page.first >= page.total || page.size == 0) {
+        page.firstId = page.lastId = page.firstPriority = page.lastPriority = 0;
+        return;
+    }
+    page.slots.reserve(std::min(page.size, page.total - page.first));
+    if (page.view != PageView::ByPriority) {
+        RankFilter filter{ page.view, page.priority };
+        for (int s = selectSlot(st, filter, (long long)page.first); s != -1 && page.slots.size() < page.size;
+             s = nextSlot(st, filter, s)) {
+            page.slots.push_back(s);
+        }
+    }
+    else {
+        size_t skip = page.first;
+        int p = 1;
+        while (p <= 5 && skip >= (size_t)st.prioLive[p]) skip -= (size_t)st.prioLive[p++];
+        for (; p <= 5 && page.slots.size() < page.size; p++, skip = 0) {
+            if (st.prioLive[p] == 0) continue;
+            RankFilter filter{ PageView::Priority, p };
+            for (int s = selectSlot(st, filter, (long long)skip); s != -1 && page.slots.size() < page.size;
+                 s = nextSlot(st, filter, s)) {
+                page.slots.push_back(s);
+            }
+        }
+    }
+    int a = page.slots.front(), b = page.slots.back();
+    page.firstId = st.ids[(size_t)a];
+    page.lastId = st.ids[(size_t)b];
+    page.firstPriority = st.priority(a);
+    page.lastPriority = st.priority(b);
+}
+
+#endif
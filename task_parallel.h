@@ -0,0 +1,130 @@
+#ifndef TASK_PARALLEL_H
+#define TASK_PARALLEL_H
+
+/*
+ * Parallel scans over a TaskStore
+ *
+ * WorkerPool keeps a few threads parked on a condition variable and splits a
+ * range of slots between them and the calling thread. filterSlots() uses it
+ * to collect matching slots: each part fills its own vector and the parts
+ * are joined in order, so the result is in slot order (= list order), just
+ * like a serial loop.
+ *
+ * Stores smaller than PARALLEL_MIN_SLOTS are scanned on the calling thread;
+ * waking the pool costs more than scanning a few thousand bytes.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "task_store.h"
+
+const size_t PARALLEL_MIN_SLOTS = 1 << 16;
+
+class WorkerPool {
+public:
+    // 'threads' counts the calling thread too; 0 = one per hardware thread
+    explicit WorkerPool(int threads = 0) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        parts = std::max(threads, 1);
+        for (int i = 1; i < parts; i++) workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return parts; }
+
+    // split [0, n) into size() contiguous parts and call fn(part, begin, end)
+    // for each; the caller runs part 0. Returns when every part is done.
+    void run(size_t n, const std::function<void(int, size_t, size_t)>& fn) {
+        std::unique_lock<std::mutex> lk(mtx);
+        job = &fn;
+        jobSize = n;
+        pending = parts - 1;
+        generation++;
+        lk.unlock();
+        wake.notify_all();
+
+        runPart(0);
+
+        lk.lock();
+        finished.wait(lk, [&] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    void runPart(int part) {
+        size_t begin = jobSize * part / parts;
+        size_t end = jobSize * (part + 1) / parts;
+        (*job)(part, begin, end);
+    }
+
+    void workerLoop(int part) {
+        unsigned long seen = 0;
+        std::unique_lock<std::mutex> lk(mtx);
+        while (true) {
+            wake.wait(lk, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            lk.unlock();
+            runPart(part);
+            lk.lock();
+            if (--pending == 0) finished.notify_one();
+        }
+    }
+
+    int parts = 1;
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable wake, finished;
+    const std::function<void(int, size_t, size_t)>* job = nullptr;
+    size_t jobSize = 0;
+    int pending = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+};
+
+// every slot s with keep(s), in slot order. 'pool' may be null (always serial).
+template <class Store, class Keep>
+std::vector<int> filterSlots(const Store& store, WorkerPool* pool, Keep keep) {
+    size_t n = (size_t)store.slotCount();
+    std::vector<int> result;
+    if (pool == nullptr || pool->size() == 1 || n < PARALLEL_MIN_SLOTS) {
+        for (size_t s = 0; s < n; s++) {
+            if (keep((int)s)) result.push_back((int)s);
+        }
+        return result;
+    }
+
+    std::vector<std::vector<int>> partial(pool->size());
+    pool->run(n, [&](int part, size_t begin, size_t end) {
+        std::vector<int>& out = partial[part];
+        for (size_t s = begin; s < end; s++) {
+            if (keep((int)s)) out.push_back((int)s);
+        }
+    });
+
+    size_t total = 0;
+    for (const std::vector<int>& p : partial) total += p.size();
+    result.resize(total);
+    size_t at = 0;
+    for (const std::vector<int>& p : partial) {
+        if (!p.empty()) memcpy(result.data() + at, p.data(), p.size() * sizeof(int));
+        at += p.size();
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef TASK_PERSIST_H
+#define TASK_PERSIST_H
+
+/*
+ * AsyncWriter - file writes on a background thread
+ *
+ * The caller hands over a job that owns everything it needs, typically a copy
+ * of the task store taken under the engine's lock (one version of the task
+ * set, which later edits do not touch), and carries on. The worker thread
+ * runs the jobs in order. writeFileAtomically() writes next to the target and
+ * renames over it once the file is complete, so nobody ever reads half a file.
+ *
+ * Jobs for the same path collapse: one still waiting when a newer one for
+ * that path arrives is dropped, since the newer one has the later data.
+ * flush() is the barrier: it returns once every job submitted so far has
+ * finished. Paths whose write failed are kept until takeFailures().
+ *
+ * The thread is started by the first submit() and stopped by the destructor
+ * (after the jobs still queued).
+ */
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// write(std::ostream&) into path + ".tmp" and rename it over 'path';
+// false (and no file change) if anything fails
+template <class Write>
+bool writeFileAtomically(const std::string& path, Write write) {
+    std::string tmpPath = path + ".tmp";
+    bool ok;
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out.is_open()) return false;
+        std::vector<char> buffer(1 << 20);
+        out.rdbuf()->pubsetbuf(buffer.data(), (std::streamsize)buffer.size());
+        write(out);
+        out.close();
+        ok = !out.fail();
+    }
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+        ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) std::remove(tmpPath.c_str());
+    return ok;
+}
+
+class AsyncWriter {
+public:
+    using Job = std::function<bool()>;     // writes one file, false if it failed
+
+    AsyncWriter() {}
+    ~AsyncWriter() {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    void submit(const std::string& path, Job job) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!worker.joinable()) worker = std::thread(&AsyncWriter::run, this);
+        for (Pending& p : queue) {
+            if (p.path == path) {
+                p.job = std::move(job);     // not started yet: the newer data replaces it
+                return;
+            }
+        }
+        queue.push_back(Pending{ path, std::move(job) });
+        cv.notify_all();
+    }
+
+    // block until every job submitted so far has finished
+    void flush() {
+        std::unique_lock<std::mutex> lk(mtx);
+        idleCv.wait(lk, [&] { return queue.empty() && !writing; });
+    }
+
+    bool busy() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return writing || !queue.empty();
+    }
+
+    // paths whose last write failed, once each
+    std::vector<std::string> takeFailures() {
+        std::lock_guard<std::mutex> lk(mtx);
+        std::vector<std::string> out;
+        out.swap(failures);
+        return out;
+    }
+
+private:
+    struct Pending {
+        std::string path;
+        Job job;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mtx);
+        while (true) {
+            cv.wait(lk, [&] { return stopping || !queue.empty(); });
+            if (queue.empty()) break;   // stopping, nothing left
+            Pending next = std::move(queue.front());
+            queue.pop_front();
+            writing = true;
+            lk.unlock();
+            bool ok = next.job();
+            next.job = nullptr;         // free the copy before taking the lock again
+            lk.lock();
+            if (!ok) failures.push_back(next.path);
+            writing = false;
+            if (queue.empty()) idleCv.notify_all();
+        }
+    }
+
+    std::thread worker;
+    std::mutex mtx;                 // guards everything below
+    std::condition_variable cv, idleCv;
+    std::deque<Pending> queue;
+    std::vector<std::string> failures;
+    bool writing = false;
+    bool stopping = false;
+};
+
+#endif
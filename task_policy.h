@@ -0,0 +1,243 @@
+#ifndef TASK_POLICY_H
+#define TASK_POLICY_H
+
+/*
+ * Policies for BasicTaskEngine (task_engine.h)
+ *
+ * The engine is a template over four choices, fixed at compile time so a
+ * build pays for none of the ones it does not use:
+ *
+ *   index    id -> node          FlatIndex (FlatIdMap, task_idmap.h)
+ *                                HashIndex (std::unordered_map)
+ *   nodes    list node memory    SlabNodes (TaskNodePool: 4096-node slabs and
+ *                                a freelist), HeapNodes (new / delete per task),
+ *                                ArenaNodes (slabs shared by every engine in the
+ *                                process, TaskNodeArena)
+ *   sync     threading           SingleThreaded (no locking at all)
+ *                                Locked (one recursive mutex around every operation)
+ *   store    task columns        WithPriorityIndex (TaskStore's per-priority lists)
+ *                                WithoutPriorityIndex (8 bytes less per task,
+ *                                priority listings scan the column)
+ *
+ * task_engine.h names the variants in use: TaskEngine (both programs),
+ * LeanTaskEngine (small footprint, one thread), SharedTaskEngine (shared
+ * between threads) and HostedTaskEngine (one of many lists in a server,
+ * task_server.h).
+ */
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "task_idmap.h"
+#include "task_store.h"
+
+// one task in the list; description, priority and completed live in the store at 'slot'
+struct TaskNode {
+    int id;
+    int slot;
+    TaskNode* next;
+    TaskNode* prev;     // doubly linked so a node from the map can be unlinked in O(1)
+};
+
+// nodes are carved out of large slabs and recycled through a freelist
+// instead of new/delete per task
+class TaskNodePool {
+public:
+    static const int SLAB_SIZE = 4096;
+    static constexpr bool releasesAll = true;   // releaseAll() frees the nodes still in use too
+
+    TaskNodePool() = default;
+    ~TaskNodePool() { releaseAll(); }
+    TaskNodePool(const TaskNodePool&) = delete;
+    TaskNodePool& operator=(const TaskNodePool&) = delete;
+
+    TaskNode* acquire() {
+        if (freeList) {
+            TaskNode* n = freeList;
+            freeList = n->next;
+            return n;
+        }
+        if (usedInSlab == SLAB_SIZE) {
+            slabs.push_back(new TaskNode[SLAB_SIZE]);
+            usedInSlab = 0;
+        }
+        return &slabs.back()[usedInSlab++];
+    }
+
+    void release(TaskNode* n) {
+        n->prev = nullptr;
+        n->next = freeList;
+        freeList = n;
+    }
+
+    // drop every node at once (one delete[] per slab)
+    void releaseAll() {
+        for (TaskNode* slab : slabs) delete[] slab;
+        slabs.clear();
+        freeList = nullptr;
+        usedInSlab = SLAB_SIZE;
+    }
+
+private:
+    std::vector<TaskNode*> slabs;
+    TaskNode* freeList = nullptr;   // released nodes, chained through next
+    int usedInSlab = SLAB_SIZE;     // nodes handed out from the newest slab
+};
+
+// one node per task, no slabs: nothing is held beyond the tasks themselves
+class HeapNodePool {
+public:
+    static constexpr bool releasesAll = false;  // the owner releases its nodes one by one
+
+    TaskNode* acquire() { return new TaskNode(); }
+    void release(TaskNode* n) { delete n; }
+    void releaseAll() {}
+};
+
+// slabs shared by every ArenaNodePool in the process: an engine takes nodes
+// in chunks and gives them all back when it is cleared, so the lists a server
+// has open share one set of slabs instead of holding a partly used one each,
+// and a list that is evicted leaves its nodes to the next one loaded
+class TaskNodeArena {
+public:
+    static const int SLAB_SIZE = 4096;
+    static const int CHUNK = 64;    // nodes handed to a pool at a time
+
+    static TaskNodeArena& shared() {
+        static TaskNodeArena arena;
+        return arena;
+    }
+
+    // CHUNK nodes chained through next
+    TaskNode* take() {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!freeList) {
+            slabs.emplace_back(new TaskNode[SLAB_SIZE]);
+            TaskNode* slab = slabs.back().get();
+            for (int i = 0; i < SLAB_SIZE; i++) slab[i].next = i + 1 < SLAB_SIZE ? &slab[i + 1] : freeList;
+            freeList = slab;
+            freeCount += SLAB_SIZE;
+        }
+        TaskNode* first = freeList;
+        TaskNode* last = first;
+        size_t taken = 1;
+        for (; taken < CHUNK && last->next; taken++) last = last->next;
+        freeList = last->next;
+        last->next = nullptr;
+        freeCount -= taken;
+        return first;
+    }
+
+    // a chain of nodes (through next) back to the arena
+    void give(TaskNode* first, TaskNode* last, size_t count) {
+        if (!first) return;
+        std::lock_guard<std::mutex> lk(mtx);
+        last->next = freeList;
+        freeList = first;
+        freeCount += count;
+    }
+
+    size_t slabCount() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return slabs.size();
+    }
+    size_t freeNodes() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return freeCount;
+    }
+
+private:
+    std::mutex mtx;                 // pools on several threads may share the arena
+    std::vector<std::unique_ptr<TaskNode[]>> slabs;
+    TaskNode* freeList = nullptr;
+    size_t freeCount = 0;
+};
+
+// one engine's nodes from TaskNodeArena::shared(); the engine releases its
+// nodes one by one (like HeapNodePool) and releaseAll() hands them back
+class ArenaNodePool {
+public:
+    static constexpr bool releasesAll = false;
+
+    ArenaNodePool() = default;
+    ~ArenaNodePool() { releaseAll(); }
+    ArenaNodePool(const ArenaNodePool&) = delete;
+    ArenaNodePool& operator=(const ArenaNodePool&) = delete;
+
+    TaskNode* acquire() {
+        if (!freeList) freeList = TaskNodeArena::shared().take();
+        TaskNode* n = freeList;
+        freeList = n->next;
+        return n;
+    }
+
+    void release(TaskNode* n) {
+        n->prev = nullptr;
+        n->next = freeList;
+        freeList = n;
+    }
+
+    // the nodes this pool holds (the engine released the rest first) go back to the arena
+    void releaseAll() {
+        if (!freeList) return;
+        TaskNode* last = freeList;
+        size_t count = 1;
+        for (; last->next; count++) last = last->next;
+        TaskNodeArena::shared().give(freeList, last, count);
+        freeList = nullptr;
+    }
+
+private:
+    TaskNode* freeList = nullptr;   // taken from the arena or released, chained through next
+};
+
+// ---- index ----
+
+struct FlatIndex {
+    template <class V> using Map = FlatIdMap<V>;
+};
+struct HashIndex {
+    template <class V> using Map = StdIdMap<V>;
+};
+
+// ---- nodes ----
+
+struct SlabNodes {
+    using Pool = TaskNodePool;
+};
+struct HeapNodes {
+    using Pool = HeapNodePool;
+};
+struct ArenaNodes {
+    using Pool = ArenaNodePool;
+};
+
+// ---- sync ----
+
+// a mutex that does nothing, so std::lock_guard over it compiles away
+struct NoMutex {
+    void lock() {}
+    void unlock() {}
+    bool try_lock() { return true; }
+};
+
+struct SingleThreaded {
+    using Mutex = NoMutex;
+    static constexpr bool shared = false;
+};
+// recursive: public operations call each other (add() is addTasks(), ...)
+struct Locked {
+    using Mutex = std::recursive_mutex;
+    static constexpr bool shared = true;
+};
+
+// ---- store ----
+
+struct WithPriorityIndex {
+    using Store = BasicTaskStore<true>;
+};
+struct WithoutPriorityIndex {
+    using Store = BasicTaskStore<false>;
+};
+
+#endif
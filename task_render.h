@@ -0,0 +1,171 @@
+#ifndef TASK_RENDER_H
+#define TASK_RENDER_H
+
+/*
+ * Row rendering for task listings
+ *
+ * Rows are formatted by hand (std::to_chars, no iostream manipulators) into
+ * one reusable buffer, which goes to the stream in large chunks. With
+ * std::ios::sync_with_stdio(false) a big listing then costs a handful of
+ * write() calls instead of several formatted inserts per row.
+ *
+ * Formats (--format=...):
+ *   plain  the usual human-readable rows, laid out by a RowLayout
+ *   tsv    id, priority, completed, description separated by tabs, with a
+ *          header line; tab, newline and backslash in text are escaped
+ *   json   one array of {"id","description","priority","completed"} objects
+ *
+ * Banners and summary lines are only written in plain format, so tsv/json
+ * listings can be piped straight into other tools.
+ */
+
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+enum class RenderFormat { Plain, Tsv, Json };
+
+// "--format=plain|tsv|json"; returns false for anything else
+inline bool parseFormatFlag(std::string_view arg, RenderFormat& out) {
+    const std::string_view flag = "--format=";
+    if (arg.substr(0, flag.size()) != flag) return false;
+    std::string_view name = arg.substr(flag.size());
+    if (name == "plain") out = RenderFormat::Plain;
+    else if (name == "tsv") out = RenderFormat::Tsv;
+    else if (name == "json") out = RenderFormat::Json;
+    else return false;
+    return true;
+}
+
+// how a plain row looks:
+//   <mark><idOpen><id padded to idWidth><idClose><description padded to descWidth><prioOpen><priority><prioClose>
+struct RowLayout {
+    const char* doneMark;
+    const char* pendingMark;
+    const char* idOpen;
+    int idWidth;
+    const char* idClose;
+    int descWidth;
+    const char* prioOpen;
+    const char* prioClose;
+};
+
+class RowRenderer {
+public:
+    static constexpr size_t CHUNK = 64 * 1024;     // write out once this much is buffered
+
+    RowRenderer(std::ostream& out, RenderFormat format, const RowLayout& layout)
+        : out(out), format(format), layout(layout) {
+        buf.reserve(CHUNK + 4096);
+        if (format == RenderFormat::Tsv) buf += "id\tpriority\tcompleted\tdescription\n";
+        else if (format == RenderFormat::Json) buf += '[';
+    }
+    ~RowRenderer() { finish(); }
+    RowRenderer(const RowRenderer&) = delete;
+    RowRenderer& operator=(const RowRenderer&) = delete;
+
+    bool isPlain() const { return format == RenderFormat::Plain; }
+    size_t rows() const { return rowCount; }
+
+    // text for humans (banners, totals); right-aligned in 'width' like setw
+    void plain(std::string_view text, int width = 0) {
+        if (!isPlain()) return;
+        pad(width - (int)text.size());
+        buf.append(text.data(), text.size());
+        spill();
+    }
+
+    void row(int id, std::string_view desc, int priority, bool completed) {
+        rowCount++;
+        if (format == RenderFormat::Plain) {
+            buf += completed ? layout.doneMark : layout.pendingMark;
+            buf += layout.idOpen;
+            size_t at = buf.size();
+            number(id);
+            pad(layout.idWidth - (int)(buf.size() - at));
+            buf += layout.idClose;
+            buf.append(desc.data(), desc.size());
+            pad(layout.descWidth - (int)desc.size());
+            buf += layout.prioOpen;
+            number(priority);
+            buf += layout.prioClose;
+            buf += '\n';
+        }
+        else if (format == RenderFormat::Tsv) {
+            number(id);
+            buf += '\t';
+            number(priority);
+            buf += completed ? "\t1\t" : "\t0\t";
+            tsvEscaped(desc);
+            buf += '\n';
+        }
+        else {
+            buf += rowCount == 1 ? "\n{\"id\":" : ",\n{\"id\":";
+            number(id);
+            buf += ",\"description\":\"";
+            jsonEscaped(desc);
+            buf += "\",\"priority\":";
+            number(priority);
+            buf += completed ? ",\"completed\":true}" : ",\"completed\":false}";
+        }
+        spill();
+    }
+
+    // close the json array and hand everything to the stream
+    void finish() {
+        if (finished) return;
+        finished = true;
+        if (format == RenderFormat::Json) buf += rowCount ? "\n]\n" : "]\n";
+        flush();
+    }
+
+private:
+    void number(long long v) {
+        char tmp[24];
+        std::to_chars_result r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        buf.append(tmp, (size_t)(r.ptr - tmp));
+    }
+    void pad(int n) {
+        if (n > 0) buf.append((size_t)n, ' ');
+    }
+    void tsvEscaped(std::string_view s) {
+        for (char c : s) {
+            if (c == '\t') buf += "\\t";
+            else if (c == '\n') buf += "\\n";
+            else if (c == '\r') buf += "\\r";
+            else if (c == '\\') buf += "\\\\";
+            else buf += c;
+        }
+    }
+    void jsonEscaped(std::string_view s) {
+        static const char hex[] = "0123456789abcdef";
+        for (char c : s) {
+            unsigned char u = (unsigned char)c;
+            if (c == '"' || c == '\\') { buf += '\\'; buf += c; }
+            else if (u < 0x20) {
+                buf += "\\u00";
+                buf += hex[u >> 4];
+                buf += hex[u & 15];
+            }
+            else buf += c;     // UTF-8 passes through unchanged
+        }
+    }
+    void spill() {
+        if (buf.size() >= CHUNK) flush();
+    }
+    void flush() {
+        if (!buf.empty()) out.write(buf.data(), (std::streamsize)buf.size());
+        buf.clear();
+    }
+
+    std::ostream& out;
+    RenderFormat format;
+    RowLayout layout;
+    std::string buf;
+    size_t rowCount = 0;
+    bool finished = false;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef TASK_SCHEDULE_H
+#define TASK_SCHEDULE_H
+
+/*
+ * TaskSchedule - the pending tasks in "what to do next" order
+ *
+ * An indexed binary heap of the pending tasks, ordered by
+ *
+ *   1. priority     1 (most urgent) first
+ *   2. deadline     earliest first; tasks without one after every dated task
+ *   3. id           lowest first, i.e. insertion order
+ *
+ * A position map (id -> heap index) lets set() re-key a task in place, so a
+ * priority edit, a new deadline, completing a task or bringing one back is
+ * O(log n) instead of a rebuild, and top() is O(1).
+ *
+ * The owner builds the heap on first use (build() heapifies in O(n)) and,
+ * once it is built, calls set() / remove() whenever a task's priority,
+ * deadline or pending state changes. Until then both are no-ops, so a
+ * session that never asks for the next task pays nothing.
+ *
+ * Deadlines are seconds since the Unix epoch, 0 = none. parseDeadline() and
+ * formatDeadline() convert to and from YYYY-MM-DD (midnight UTC).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include "task_idmap.h"
+
+class TaskSchedule {
+public:
+    struct Entry {
+        int64_t deadline;
+        int id;
+        int priority;
+    };
+
+    bool isBuilt() const { return built; }
+    size_t size() const { return heap.size(); }
+
+    void clear() {
+        heap.clear();
+        where.clear();
+        built = false;
+    }
+
+    // start from these tasks (any order)
+    void build(std::vector<Entry> entries) {
+        heap.swap(entries);
+        where.clear();
+        where.reserve(heap.size());
+        for (size_t i = 0; i < heap.size(); i++) where.insert(heap[i].id, (int)i);
+        for (size_t i = heap.size() / 2; i-- > 0;) siftDown(i);
+        built = true;
+    }
+
+    // add the task, or move it to where its new key belongs
+    void set(int id, int priority, int64_t deadline) {
+        if (!built) return;
+        Entry e = { deadline, id, priority };
+        int* at = where.find(id);
+        if (!at) {
+            heap.push_back(e);
+            where.insert(id, (int)heap.size() - 1);
+            siftUp(heap.size() - 1);
+            return;
+        }
+        size_t i = (size_t)*at;
+        bool earlier = before(e, heap[i]);
+        heap[i] = e;
+        if (earlier) siftUp(i);
+        else siftDown(i);
+    }
+
+    void remove(int id) {
+        if (!built) return;
+        int* at = where.find(id);
+        if (!at) return;
+        size_t i = (size_t)*at;
+        where.erase(id);
+        if (i + 1 == heap.size()) {
+            heap.pop_back();
+            return;
+        }
+        heap[i] = heap.back();
+        heap.pop_back();
+        place(i);
+        if (i > 0 && before(heap[i], heap[(i - 1) / 2])) siftUp(i);
+        else siftDown(i);
+    }
+
+    // id of the next task, 0 if nothing is pending
+    int top() const { return heap.empty() ? 0 : heap[0].id; }
+
+private:
+    static bool before(const Entry& a, const Entry& b) {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        if (a.deadline != b.deadline) {
+            if (a.deadline == 0) return false;
+            if (b.deadline == 0) return true;
+            return a.deadline < b.deadline;
+        }
+        return a.id < b.id;
+    }
+
+    void place(size_t i) { where[heap[i].id] = (int)i; }
+
+    void siftUp(size_t i) {
+        Entry e = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(e, heap[parent])) break;
+            heap[i] = heap[parent];
+            place(i);
+            i = parent;
+        }
+        heap[i] = e;
+        place(i);
+    }
+
+    void siftDown(size_t i) {
+        Entry e = heap[i];
+        size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && before(heap[child + 1], heap[child])) child++;
+            if (!before(heap[child], e)) break;
+            heap[i] = heap[child];
+            place(i);
+            i = child;
+        }
+        heap[i] = e;
+        place(i);
+    }
+
+    std::vector<Entry> heap;
+    FlatIdMap<int> where;   // id -> index in heap
+    bool built = false;
+};
+
+// ---- deadline text ----
+
+// days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's days_from_civil)
+inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// "YYYY-MM-DD" -> seconds at midnight UTC, "none" -> 0; false for anything else
+inline bool parseDeadline(std::string_view text, int64_t& out) {
+    if (text == "none") {
+        out = 0;
+        return true;
+    }
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return false;
+    int field[3] = {};
+    const size_t start[3] = { 0, 5, 8 }, len[3] = { 4, 2, 2 };
+    for (int f = 0; f < 3; f++) {
+        for (size_t i = start[f]; i < start[f] + len[f]; i++) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            field[f] = field[f] * 10 + (text[i] - '0');
+        }
+    }
+    static const int monthDays[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (field[1] < 1 || field[1] > 12 || field[2] < 1 || field[2] > monthDays[field[1] - 1]) return false;
+    bool leap = (field[0] % 4 == 0 && field[0] % 100 != 0) || field[0] % 400 == 0;
+    if (field[1] == 2 && field[2] == 29 && !leap) return false;
+    int64_t when = daysFromCivil(field[0], (unsigned)field[1], (unsigned)field[2]) * 86400;
+    if (when == 0) when = 1;    // 1970-01-01 would read as "no deadline"
+    out = when;
+    return true;
+}
+
+// the UTC date of 'when' as YYYY-MM-DD into buf (at least 11 bytes); "none" for 0
+inline const char* formatDeadline(int64_t when, char* buf, size_t size) {
+    if (when == 0) {
+        std::snprintf(buf, size, "none");
+        return buf;
+    }
+    int64_t z = (when >= 0 ? when : when - 86399) / 86400 + 719468;      // civil_from_days
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t y = (int64_t)yoe + era * 400;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    std::snprintf(buf, size, "%04lld-%02u-%02u", (long long)(y + (m <= 2)), m, d);
+    return buf;
+}
+
+#endif
@@ -0,0 +1,559 @@
+#ifndef TASK_SERVER_H
+#define TASK_SERVER_H
+
+/*
+ * TaskServer - one process serving many task lists over TCP (todo --serve=PORT)
+ *
+ * Each list is a HostedTaskEngine with its own files in the lists directory
+ * (<name>.bin / .txt / .log, the same formats as tasks.*). TaskListCache keeps
+ * at most maxOpen of them loaded: a list is loaded the first time a command
+ * names it and, when the cache is full, the least recently used one is
+ * persisted and closed to make room, so any number of lists can be served with
+ * the memory of maxOpen. The engines take their list nodes from one shared
+ * TaskNodeArena (task_policy.h), and an evicted list hands its nodes back for
+ * the next one loaded.
+ *
+ * A list's log is opened by its first change, not by loading it, so reading a
+ * list (or naming one that does not exist) creates no files, and closing a
+ * list nobody changed writes nothing. Once a list has had no command for
+ * IDLE_SECONDS its log is synced and closed, flusher thread and all, until
+ * the next change: only the lists in use hold a descriptor and a thread.
+ *
+ * The protocol is line based. A connection first picks a list, then sends the
+ * batch commands of task_batch.h, which act on that list:
+ *
+ *   use <name>         select a list (letters, digits, '-' and '_'; loaded on demand)
+ *                      and, if loading it found problems, say so in "# " lines
+ *   lists              the loaded lists, most recently used first
+ *   quit               close the connection
+ *   add 3 "buy milk"   ... any task_batch.h command
+ *
+ * Every command gets zero or more data lines (task rows as tsv, with the tsv
+ * header line; stats text) and then one status line, "OK [detail]" or
+ * "ERR <reason>", so a client reads until a line starting with OK or ERR.
+ * If a command has to load its list again (it was evicted since "use"), what
+ * the load found comes first, as the same "# " lines.
+ *
+ * One thread runs everything: an epoll loop over non-blocking sockets, with
+ * per-connection input and output buffers. A connection whose replies pile up
+ * past OUTPUT_LIMIT is not read from until the client has taken them, so a
+ * slow reader cannot make the server buffer without bound. SIGINT / SIGTERM
+ * stop the loop; every loaded list is persisted on the way out.
+ *
+ * Linux only (epoll); elsewhere run() reports that and returns 1.
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include "task_engine.h"
+#include "task_batch.h"
+#include "task_render.h"
+
+// ================================
+// What load() found, one "# " line each, as projecttt.cpp's loadTasks() says it
+// ================================
+inline void writeLoadNotes(std::string& out, const LoadReport& r, const StorageFiles& files) {
+    auto name = [](const std::string& path) { return std::filesystem::path(path).filename().string(); };
+    auto note = [&](const std::string& text) { out += "# " + text + "\n"; };
+    if (r.invalidSnapshot) note(name(files.snapshot) + " is not a valid snapshot, read " + name(files.text) + " instead");
+    const size_t shown = 10;
+    for (size_t i = 0; i < r.textErrors.size() && i < shown; i++) {
+        note(name(files.text) + " line " + std::to_string(r.textErrors[i].line) + ": " + r.textErrors[i].reason +
+             " (skipped)");
+    }
+    if (r.textErrors.size() > shown) note("... and " + std::to_string(r.textErrors.size() - shown) + " more malformed line(s) skipped");
+    if (r.droppedLog) note(name(files.text) + " replaced the saved tasks; unsaved changes in " + name(files.log) + " were dropped");
+    if (!r.logOpen) note("unable to open " + name(files.log) + "; changes are only saved when the list is closed");
+    if (r.recovered > 0) note("recovered " + std::to_string(r.recovered) + " unsaved change(s) from " + name(files.log));
+}
+
+// ================================
+// Loaded lists, least recently used evicted first
+// ================================
+class TaskListCache {
+public:
+    static constexpr int IDLE_SECONDS = 10;     // then a list's log is closed until its next change
+
+    TaskListCache(std::string directory, size_t maxOpen) : dir(std::move(directory)), maxOpen(maxOpen ? maxOpen : 1) {}
+    ~TaskListCache() { closeAll(); }
+    TaskListCache(const TaskListCache&) = delete;
+    TaskListCache& operator=(const TaskListCache&) = delete;
+
+    // applied to every list loaded from now on
+    void setUndoLimits(size_t steps, size_t bytes) {
+        undoSteps = steps;
+        undoBytes = bytes;
+    }
+    void setLazyLoad(bool lazy) { lazyLoad = lazy; }
+
+    // names become file names, so only [A-Za-z0-9_-], at most 64 of them
+    static bool isValidName(std::string_view name) {
+        if (name.empty() || name.size() > 64) return false;
+        for (char c : name) {
+            bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    // the list called 'name', loaded (and something else evicted) if need be;
+    // it stays valid until the next open(). If this call loads it and 'notes'
+    // is given, what the load found is appended there (writeLoadNotes).
+    HostedTaskEngine& open(const std::string& name, std::string* notes = nullptr) {
+        auto found = lists.find(name);
+        if (found != lists.end()) {
+            recent.splice(recent.begin(), recent, found->second.lru);
+            found->second.lastUsed = std::chrono::steady_clock::now();
+            return *found->second.engine;
+        }
+        while (lists.size() >= maxOpen) evict(recent.back());
+
+        Entry entry;
+        entry.engine.reset(new HostedTaskEngine());
+        HostedTaskEngine& list = *entry.engine;
+        StorageFiles files;
+        std::filesystem::path base = std::filesystem::path(dir) / name;
+        files.snapshot = base.string() + ".bin";
+        files.text = base.string() + ".txt";
+        files.log = base.string() + ".log";
+        list.setStorageFiles(files);
+        list.setUndoLimits(undoSteps, undoBytes);
+        list.setLazyLoad(lazyLoad);
+        list.setLogOnDemand(true);
+        LoadReport report = list.load();
+        if (notes) writeLoadNotes(*notes, report, files);
+        loadCount++;
+        recent.push_front(name);
+        entry.lru = recent.begin();
+        entry.lastUsed = std::chrono::steady_clock::now();
+        return *lists.emplace(name, std::move(entry)).first->second.engine;
+    }
+
+    // close the logs of the lists no command has used for IDLE_SECONDS;
+    // cheap to call often, it looks at most once a second
+    void releaseIdle() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSweep < std::chrono::seconds(1)) return;
+        lastSweep = now;
+        auto idleSince = now - std::chrono::seconds(IDLE_SECONDS);
+        for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+            Entry& entry = lists.find(*it)->second;
+            if (entry.lastUsed > idleSince) break;  // the rest were used later still
+            entry.engine->releaseLog();
+        }
+    }
+
+    // persist and close every loaded list
+    void closeAll() {
+        while (!recent.empty()) evict(recent.back());
+    }
+
+    size_t openCount() const { return lists.size(); }
+    size_t capacity() const { return maxOpen; }
+    size_t loads() const { return loadCount; }
+    size_t evictions() const { return evictCount; }
+
+    // fn(name, list) from the most recently used on
+    template <class Fn>
+    void forEach(Fn fn) {
+        for (const std::string& name : recent) fn(name, *lists.find(name)->second.engine);
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<HostedTaskEngine> engine;
+        std::list<std::string>::iterator lru;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    void evict(std::string name) {  // by value: it is the list node being erased
+        auto found = lists.find(name);
+        HostedTaskEngine& list = *found->second.engine;
+        list.persist();
+        list.close();   // its nodes go back to the shared arena
+        recent.erase(found->second.lru);
+        lists.erase(found);
+        evictCount++;
+    }
+
+    std::string dir;
+    size_t maxOpen;
+    size_t undoSteps = UndoJournal::DEFAULT_STEPS;
+    size_t undoBytes = UndoJournal::DEFAULT_BUDGET;
+    bool lazyLoad = false;
+    std::unordered_map<std::string, Entry> lists;
+    std::list<std::string> recent;  // most recently used first
+    size_t loadCount = 0, evictCount = 0;
+    std::chrono::steady_clock::time_point lastSweep;
+};
+
+// an ostream that appends to a std::string (a connection's output buffer)
+class StringAppendBuf : public std::streambuf {
+public:
+    explicit StringAppendBuf(std::string& target) : target(target) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) target += (char)c;
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        target.append(s, (size_t)n);
+        return n;
+    }
+
+private:
+    std::string& target;
+};
+
+// ================================
+// One batch command on a hosted list, with its reply
+// ================================
+// data lines go to 'out'; returns nullptr on success (detail gets what follows
+// "OK"), otherwise the reason
+inline const char* runHostedCommand(HostedTaskEngine& list, const BatchCommand& cmd, std::ostream& out,
+                                    std::string& detail) {
+    static const RowLayout layout = { "", "", "", 0, "", 0, "", "" };   // tsv ignores it
+    const auto& st = list.tasks();
+    switch (cmd.op) {
+    case BATCH_NONE:
+        return nullptr;
+    case BATCH_ADD: {
+        if (cmd.priority < 1 || cmd.priority > 5) return "priority must be 1-5";
+        int id = list.add(cmd.text, cmd.priority);
+        if (!id) return "description cannot be empty";
+        detail = std::to_string(id);
+        return nullptr;
+    }
+    case BATCH_EDIT:
+        if (cmd.priority < 0 || cmd.priority > 5) return "priority must be 0-5";
+        return list.update(cmd.id, cmd.text, cmd.priority) ? nullptr : "task not found";
+    case BATCH_DONE:
+    case BATCH_UNDONE:
+        return list.setCompleted(cmd.id, cmd.op == BATCH_DONE) ? nullptr : "task not found";
+    case BATCH_DEL:
+        return list.remove(cmd.id) ? nullptr : "task not found";
+    case BATCH_UNDO:
+        return list.undo().applied ? nullptr : "nothing to undo";
+    case BATCH_REDO:
+        return list.redo().applied ? nullptr : "nothing to redo";
+    case BATCH_CLEAR:
+        detail = std::to_string(list.removeCompleted());
+        return nullptr;
+    case BATCH_LIST: {
+        MetricTimer timer(list.metrics(), OP_LIST);
+        timer.items((uint64_t)list.count());
+        RowRenderer rows(out, RenderFormat::Tsv, layout);
+        for (const TaskNode* cur = list.front(); cur; cur = cur->next) {
+            rows.row(cur->id, st.description(cur->slot), st.priority(cur->slot), st.isCompleted(cur->slot));
+        }
+        detail = std::to_string(rows.rows());
+        return nullptr;
+    }
+    case BATCH_FIND: {
+        std::vector<int> ids = list.search(cmd.text);
+        RowRenderer rows(out, RenderFormat::Tsv, layout);
+        for (int id : ids) {
+            int s = list.find(id)->slot;
+            rows.row(id, st.description(s), st.priority(s), st.isCompleted(s));
+        }
+        detail = std::to_string(rows.rows());
+        return nullptr;
+    }
+    case BATCH_SAVE:
+        return list.checkpoint() ? nullptr : "unable to write the snapshot";
+    case BATCH_STATS:
+        if (cmd.text.empty() || cmd.text == "plain") writeStatsTable(out, list.metrics(), list.gauges());
+        else if (cmd.text == "prometheus") writePrometheus(out, list.metrics(), list.gauges());
+        else if (cmd.text == "json") writeMetricsJson(out, list.metrics(), list.gauges());
+        else return "stats format must be plain, prometheus or json";
+        return nullptr;
+    case BATCH_DUE:
+        return list.setDeadline(cmd.id, cmd.deadline) ? nullptr : "task not found";
+    case BATCH_NEXT: {
+        int id = list.peekNext();
+        if (!id) return "no pending tasks";
+        int s = list.find(id)->slot;
+        RowRenderer rows(out, RenderFormat::Tsv, layout);
+        rows.row(id, st.description(s), st.priority(s), st.isCompleted(s));
+        detail = std::to_string(id);
+        return nullptr;
+    }
+    case BATCH_POP: {
+        int id = list.popNext();
+        if (!id) return "no pending tasks";
+        detail = std::to_string(id);
+        return nullptr;
+    }
+    case BATCH_PAGE: {
+        PageView view;
+        int prio;
+        parseView(cmd.text, view, prio);
+        TaskPage page = list.page(view, (size_t)cmd.page - 1, (size_t)cmd.pageSize, prio);
+        RowRenderer rows(out, RenderFormat::Tsv, layout);
+        for (int s : page.slots) rows.row(st.ids[s], st.description(s), st.priority(s), st.isCompleted(s));
+        detail = "page " + std::to_string(page.number()) + " of " + std::to_string(page.pages());
+        return nullptr;
+    }
+    }
+    return "unknown command";
+}
+
+// ================================
+// The event loop
+// ================================
+class TaskServer {
+public:
+    static constexpr size_t OUTPUT_LIMIT = 4u << 20;   // stop reading a client with this much unsent
+    static constexpr size_t LINE_LIMIT = 1u << 20;     // longest command line accepted
+
+    explicit TaskServer(TaskListCache& lists) : lists(lists) {}
+
+    // listen on 127.0.0.1:port (every interface if bindAll) until SIGINT /
+    // SIGTERM; returns the exit code. Progress goes to 'log'.
+    int run(int port, bool bindAll, std::ostream& log);
+
+private:
+    struct Connection {
+        std::string in;
+        std::string out;
+        size_t sent = 0;            // of out
+        std::string list;           // selected with "use", empty = none
+        bool quit = false;          // "quit" (or a line too long): close once out is sent
+        bool eof = false;           // the client sent everything: close once it is answered
+
+        bool backedUp() const { return out.size() - sent >= OUTPUT_LIMIT; }
+        bool reading() const { return !quit && !eof && !backedUp(); }
+        bool finished() const {
+            return sent == out.size() && (quit || (eof && in.find('\n') == std::string::npos));
+        }
+    };
+
+    // run the complete lines in c.in while the output has room
+    void serveLines(Connection& c) {
+        size_t start = 0;
+        while (!c.quit && !c.backedUp()) {
+            size_t end = c.in.find('\n', start);
+            if (end == std::string::npos) break;
+            serveLine(c, c.in.data() + start, c.in.data() + end);
+            start = end + 1;
+        }
+        c.in.erase(0, start);
+        if (!c.quit && c.in.size() > LINE_LIMIT && c.in.find('\n') == std::string::npos) {
+            c.out += "ERR line too long\n";
+            c.quit = true;
+        }
+    }
+
+    void serveLine(Connection& c, const char* b, const char* e) {
+        const char* p = b;
+        std::string_view verb = batchWord(p, e);
+        if (verb.empty() || verb[0] == '#') return;
+        if (verb == "quit") {
+            c.out += "OK bye\n";
+            c.quit = true;
+            return;
+        }
+        if (verb == "use") {
+            std::string_view name = batchWord(p, e);
+            if (!TaskListCache::isValidName(name) || !batchWord(p, e).empty()) {
+                c.out += "ERR list names are 1-64 letters, digits, '-' or '_'\n";
+                return;
+            }
+            c.list.assign(name.data(), name.size());
+            HostedTaskEngine& list = lists.open(c.list, &c.out);
+            c.out += "OK " + c.list + " " + std::to_string(list.count()) + " task(s)\n";
+            return;
+        }
+        if (verb == "lists") {
+            lists.forEach([&](const std::string& name, HostedTaskEngine& list) {
+                c.out += name + "\t" + std::to_string(list.count()) + "\n";
+            });
+            c.out += "OK " + std::to_string(lists.openCount()) + " of " + std::to_string(lists.capacity()) +
+                     " loaded, " + std::to_string(lists.loads()) + " load(s), " + std::to_string(lists.evictions()) +
+                     " eviction(s), " + std::to_string(TaskNodeArena::shared().slabCount()) + " node slab(s)\n";
+            return;
+        }
+
+        const char* reason = parseBatchLine(b, e, cmd, scratch);
+        std::string detail;
+        if (!reason && c.list.empty()) reason = "no list selected (use <name>)";
+        if (!reason) {
+            StringAppendBuf buf(c.out);
+            std::ostream out(&buf);
+            HostedTaskEngine& list = lists.open(c.list, &c.out);
+            reason = runHostedCommand(list, cmd, out, detail);
+            for (const std::string& path : list.failedSaves()) {
+                c.out += "# unable to write " + std::filesystem::path(path).filename().string() + "\n";
+            }
+        }
+        if (reason) c.out += std::string("ERR ") + reason + "\n";
+        else c.out += detail.empty() ? "OK\n" : "OK " + detail + "\n";
+    }
+
+    TaskListCache& lists;
+    BatchCommand cmd;
+    std::string scratch;
+};
+
+#ifdef __linux__
+
+// set by SIGINT / SIGTERM, checked by the loop at least once a second
+inline volatile std::sig_atomic_t serverStopRequested = 0;
+inline void requestServerStop(int) { serverStopRequested = 1; }
+
+inline int TaskServer::run(int port, bool bindAll, std::ostream& log) {
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        log << "✗ socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(bindAll ? INADDR_ANY : INADDR_LOOPBACK);
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 128) != 0) {
+        log << "✗ Unable to listen on port " << port << ": " << std::strerror(errno) << "\n";
+        ::close(listener);
+        return 1;
+    }
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listener;
+    epoll_ctl(ep, EPOLL_CTL_ADD, listener, &ev);
+
+    serverStopRequested = 0;
+    std::signal(SIGINT, requestServerStop);
+    std::signal(SIGTERM, requestServerStop);
+    std::signal(SIGPIPE, SIG_IGN);  // a client gone mid-reply is an EPIPE, not the end of the server
+    log << "✓ Serving task lists on port " << port << " (at most " << lists.capacity() << " loaded).\n";
+    log.flush();
+
+    std::unordered_map<int, Connection> conns;
+    // watch for input unless the output is backed up, for output while some is unsent
+    auto watch = [&](int fd, Connection& c, int op) {
+        epoll_event e;
+        std::memset(&e, 0, sizeof(e));
+        e.events = (c.reading() ? (uint32_t)(EPOLLIN | EPOLLRDHUP) : 0u) | (c.sent < c.out.size() ? (uint32_t)EPOLLOUT : 0u);
+        e.data.fd = fd;
+        epoll_ctl(ep, op, fd, &e);
+    };
+    auto drop = [&](int fd) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        conns.erase(fd);
+    };
+    // send what the socket takes; false if the client is gone
+    auto flushOut = [&](int fd, Connection& c) {
+        while (c.sent < c.out.size()) {
+            ssize_t n = ::send(fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (n > 0) c.sent += (size_t)n;
+            else if (n < 0 && errno == EINTR) continue;
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            else return false;
+        }
+        c.out.clear();
+        c.sent = 0;
+        return true;
+    };
+
+    std::vector<epoll_event> events(256);
+    std::vector<char> buf(64 * 1024);
+    while (!serverStopRequested) {
+        int ready = epoll_wait(ep, events.data(), (int)events.size(), 1000);
+        if (ready < 0 && errno != EINTR) {
+            log << "✗ epoll_wait: " << std::strerror(errno) << "\n";
+            break;
+        }
+        lists.releaseIdle();
+        for (int i = 0; i < ready; i++) {
+            int fd = events[(size_t)i].data.fd;
+            uint32_t what = events[(size_t)i].events;
+            if (fd == listener) {
+                while (true) {
+                    int client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0) break;  // EAGAIN: accepted them all (or out of descriptors for now)
+                    watch(client, conns[client], EPOLL_CTL_ADD);
+                }
+                continue;
+            }
+            auto found = conns.find(fd);
+            if (found == conns.end()) continue;
+            Connection& c = found->second;
+
+            if ((what & EPOLLERR) && !(what & EPOLLIN)) {
+                drop(fd);
+                continue;
+            }
+            while (c.reading() && c.in.size() <= LINE_LIMIT) {    // serve what is there before reading more
+                ssize_t n = ::read(fd, buf.data(), buf.size());
+                if (n > 0) c.in.append(buf.data(), (size_t)n);
+                else if (n < 0 && errno == EINTR) continue;
+                else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                else {
+                    // end of input (or an error): answer what came, then close
+                    if (!c.in.empty() && c.in.back() != '\n') c.in += '\n';   // a last line without its newline
+                    c.eof = true;
+                }
+            }
+            // lines held back while the output was full run as soon as it drains
+            bool alive = true;
+            do {
+                serveLines(c);
+                alive = flushOut(fd, c);
+            } while (alive && c.out.empty() && !c.quit && c.in.find('\n') != std::string::npos);
+            if (!alive || c.finished()) {
+                drop(fd);
+                continue;
+            }
+            watch(fd, c, EPOLL_CTL_MOD);
+        }
+    }
+
+    for (auto& entry : conns) ::close(entry.first);
+    ::close(ep);
+    ::close(listener);
+    lists.closeAll();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    log << "✓ Server stopped; every list saved.\n";
+    return 0;
+}
+
+#else
+
+inline int TaskServer::run(int, bool, std::ostream& log) {
+    log << "✗ Server mode needs epoll (Linux).\n";
+    return 1;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,466 @@
+#ifndef TASK_SNAPSHOT_H
+#define TASK_SNAPSHOT_H
+
+/*
+ * Binary snapshot of the task list (tasks.bin)
+ *
+ *   SnapshotHeader                  fixed size
+ *   SnapshotRecord x count          fixed size, one per task, in list order
+ *   description blob                all descriptions back to back
+ *   int64 deadline x count          only if flags has SNAPSHOT_DEADLINES
+ *
+ * Numbers are written in the machine's native byte order. The magic and
+ * version in the header are checked on load; anything that does not match
+ * (or does not fit in the file) is rejected and the caller falls back to the
+ * text format.
+ *
+ * Version 2 added logSequence: the last tasks.log record the snapshot already
+ * contains (see task_log.h). Version 1 files are still read, as sequence 0.
+ * Version 3 turned the reserved header word into flags; the deadline array
+ * is only written when some task has a deadline. Older files have none.
+ *
+ * A checkpoint that only changed some tasks' priority, completed state or
+ * deadline, or deleted some, does not rewrite the file: patchSnapshot()
+ * overwrites those tasks' records where they are (a deleted task's record is
+ * marked removed and skipped on load) and then the header. SnapshotLayout
+ * remembers which record holds which task. Files with removed records carry
+ * SNAPSHOT_REMOVED, which builds from before it reject, as they would any
+ * flag they do not know. Patching is not atomic like the rename, but the
+ * records are fsynced before the header's logSequence is written (and the
+ * header before the log is emptied), so after a crash part way through,
+ * load() replays the log from the old sequence on top of the records, and
+ * every log record sets a value rather than changing one.
+ *
+ * Loading maps the file read-only, so a TaskStore can borrow its descriptions
+ * straight from the mapping instead of copying them. The MappedFile has to
+ * outlive every borrowed description. A lazy load (TaskEngine::setLazyLoad)
+ * also turns off read-ahead for the description blob, so only the records are
+ * read at startup and a description's page is read when it is first used.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "task_store.h"
+
+const char SNAPSHOT_MAGIC[8] = { 'T', 'O', 'D', 'O', 'S', 'N', 'A', 'P' };
+const uint32_t SNAPSHOT_VERSION = 3;
+const size_t SNAPSHOT_V1_HEADER_SIZE = 40;  // version 1 ended before logSequence
+const uint32_t SNAPSHOT_DEADLINES = 1;      // header flag: the deadline array follows the blob
+const uint32_t SNAPSHOT_REMOVED = 2;        // header flag: some records are deleted tasks
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;    // sizeof(SnapshotRecord) when written
+    uint64_t count;         // number of records
+    uint64_t blobSize;      // bytes of description text after the records
+    int32_t nextId;
+    uint32_t flags;         // version 3+, 0 before
+    uint64_t logSequence;   // version 2+
+};
+
+struct SnapshotRecord {
+    int32_t id;
+    uint32_t descLength;
+    uint64_t descOffset;    // from the start of the blob
+    uint8_t priority;
+    uint8_t completed;
+    uint8_t removed;        // only with SNAPSHOT_REMOVED: a deleted task, skip it
+    uint8_t reserved[5];
+};
+
+// ================================
+// Read-only view of a whole file (mmap, or a plain read where mmap is missing)
+// ================================
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        buffer.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(&buffer[0], (std::streamsize)buffer.size());
+        if (!in) { buffer.clear(); return false; }
+        ptr = buffer.data();
+        len = buffer.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);    // the mapping stays valid without the descriptor
+        if (p == MAP_FAILED) return false;
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        ptr = (const char*)p;
+        len = (size_t)st.st_size;
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        std::vector<char>().swap(buffer);
+#else
+        if (ptr) munmap((void*)ptr, len);
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool isOpen() const { return ptr != nullptr; }
+
+    // bytes from 'offset' on will be read here and there, not in order: don't
+    // read ahead for them (the whole file is mapped sequential by default)
+    void adviseRandom(size_t offset) {
+#ifndef _WIN32
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t from = (offset + page - 1) / page * page;
+        if (ptr && from < len) madvise((void*)(ptr + from), len - from, MADV_RANDOM);
+#else
+        (void)offset;
+#endif
+    }
+
+private:
+    const char* ptr = nullptr;
+    size_t len = 0;
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+// ================================
+// Pointers into a loaded snapshot
+// ================================
+struct SnapshotView {
+    const SnapshotHeader* header = nullptr;
+    const SnapshotRecord* records = nullptr;
+    const char* blob = nullptr;
+    const char* deadlines = nullptr;    // int64 per record, unaligned; null if none
+
+    uint64_t logSequence = 0;
+
+    uint64_t count() const { return header->count; }
+    std::string_view description(const SnapshotRecord& r) const {
+        return std::string_view(blob + r.descOffset, r.descLength);
+    }
+    int64_t deadline(uint64_t i) const {
+        if (!deadlines) return 0;
+        int64_t when;
+        memcpy(&when, deadlines + i * sizeof(int64_t), sizeof(when));
+        return when;
+    }
+};
+
+// check that the file really is a snapshot we can read, and fill in 'view'
+inline bool openSnapshot(const MappedFile& file, SnapshotView& view) {
+    if (file.size() < SNAPSHOT_V1_HEADER_SIZE) return false;
+    const SnapshotHeader* h = (const SnapshotHeader*)file.data();
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) return false;
+    if (h->version < 1 || h->version > SNAPSHOT_VERSION || h->recordSize != sizeof(SnapshotRecord)) return false;
+    size_t headerSize = (h->version == 1) ? SNAPSHOT_V1_HEADER_SIZE : sizeof(SnapshotHeader);
+    if (file.size() < headerSize) return false;
+
+    uint64_t recordBytes = h->count * sizeof(SnapshotRecord);
+    if (h->count > file.size() / sizeof(SnapshotRecord)) return false;
+    uint32_t flags = (h->version >= 3) ? h->flags : 0;
+    if (flags & ~(SNAPSHOT_DEADLINES | SNAPSHOT_REMOVED)) return false;
+    uint64_t deadlineBytes = (flags & SNAPSHOT_DEADLINES) ? h->count * sizeof(int64_t) : 0;
+    if (h->blobSize > file.size() || headerSize + recordBytes + h->blobSize + deadlineBytes != file.size()) return false;
+
+    view.header = h;
+    view.logSequence = (h->version == 1) ? 0 : h->logSequence;
+    view.records = (const SnapshotRecord*)(file.data() + headerSize);
+    view.blob = file.data() + headerSize + recordBytes;
+    view.deadlines = deadlineBytes ? view.blob + h->blobSize : nullptr;
+    for (uint64_t i = 0; i < h->count; i++) {
+        const SnapshotRecord& r = view.records[i];
+        if (r.descOffset > h->blobSize || r.descLength > h->blobSize - r.descOffset) return false;
+        if (r.priority < 1 || r.priority > 5) return false;
+    }
+    return true;
+}
+
+// ================================
+// Where each task's record is in the file on disk
+// ================================
+class SnapshotLayout {
+public:
+    bool isValid() const { return valid; }
+    const SnapshotHeader& header() const { return h; }
+    uint64_t removedCount() const { return removed; }
+    bool isRemoved(uint64_t record) const { return removedAt[(size_t)record]; }
+    size_t bytes() const { return byId.capacity() * sizeof(Entry) + removedAt.capacity() / 8; }
+
+    void clear() {
+        std::vector<Entry>().swap(byId);
+        std::vector<bool>().swap(removedAt);
+        removed = 0;
+        valid = false;
+    }
+
+    // the file has header 'header' and these ids in record order; isRemoved
+    // (null: none) gives each record's removed flag
+    void assign(const SnapshotHeader& header, const int32_t* ids, const uint8_t* isRemovedFlags) {
+        h = header;
+        size_t n = (size_t)h.count;
+        byId.resize(n);
+        removedAt.assign(n, false);
+        removed = 0;
+        for (size_t i = 0; i < n; i++) {
+            byId[i] = Entry{ ids[i], (uint32_t)i };
+            if (isRemovedFlags && isRemovedFlags[i]) {
+                removedAt[i] = true;
+                removed++;
+            }
+        }
+        // tasks are added with rising ids at the end of the list, so this is usually sorted already
+        auto byIdLess = [](const Entry& a, const Entry& b) { return a.id < b.id; };
+        if (!std::is_sorted(byId.begin(), byId.end(), byIdLess)) std::sort(byId.begin(), byId.end(), byIdLess);
+        valid = true;
+    }
+
+    // the records of a loaded snapshot; older versions are left invalid
+    // (their header is shorter), the first checkpoint rewrites them
+    void assign(const SnapshotView& view) {
+        if (view.header->version != SNAPSHOT_VERSION) {
+            clear();
+            return;
+        }
+        size_t n = (size_t)view.count();
+        std::vector<int32_t> ids(n);
+        std::vector<uint8_t> flags(n);
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = view.records[i].id;
+            flags[i] = view.records[i].removed;
+        }
+        bool anyRemoved = (view.header->flags & SNAPSHOT_REMOVED) != 0;
+        assign(*view.header, ids.data(), anyRemoved ? flags.data() : nullptr);
+    }
+
+    // record holding task 'id', -1 if the file does not have it
+    long long find(int id) const {
+        auto it = std::lower_bound(byId.begin(), byId.end(), id, [](const Entry& e, int v) { return e.id < v; });
+        return (it != byId.end() && it->id == id) ? (long long)it->record : -1;
+    }
+
+    void setRemoved(uint64_t record, bool isRemoved) {
+        if (removedAt[(size_t)record] == isRemoved) return;
+        removedAt[(size_t)record] = isRemoved;
+        if (isRemoved) removed++;
+        else removed--;
+    }
+    void setHeader(const SnapshotHeader& header) { h = header; }
+
+private:
+    struct Entry {
+        int32_t id;
+        uint32_t record;
+    };
+    SnapshotHeader h{};
+    std::vector<Entry> byId;        // sorted by id
+    std::vector<bool> removedAt;    // per record
+    uint64_t removed = 0;
+    bool valid = false;
+};
+
+// ================================
+// Durability: a rename or a log truncate may only follow data that is on disk
+// ================================
+// flush 'f' and fsync it
+inline bool syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// fsync the directory holding 'path', so a rename into it survives a crash
+// (Windows has no directory handles for this; its renames are journaled)
+inline bool syncParentDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// write the slots listed in 'order' to 'path'.
+// The file is written next to the target, fsynced and renamed over it at the
+// end, and the directory is fsynced after the rename, so once this returns
+// true the new snapshot survives a crash and the log it contains may go; a
+// crash mid-save never leaves a half-written snapshot behind.
+// 'layout' (if given) is set to the new file's once it is in place.
+template <class Store>
+bool writeSnapshot(const std::string& path, const Store& store,
+                          const std::vector<int>& order, int nextId, uint64_t logSequence = 0,
+                          SnapshotLayout* layout = nullptr) {
+    std::string tmpPath = path + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) return false;
+    std::vector<char> ioBuffer(1 << 20);
+    setvbuf(f, ioBuffer.data(), _IOFBF, ioBuffer.size());
+
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    h.version = SNAPSHOT_VERSION;
+    h.recordSize = sizeof(SnapshotRecord);
+    h.count = order.size();
+    h.nextId = nextId;
+    h.logSequence = logSequence;
+    if (store.hasDeadlines()) h.flags = SNAPSHOT_DEADLINES;
+    for (int s : order) h.blobSize += store.description(s).size();
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    uint64_t offset = 0;
+    for (size_t i = 0; ok && i < order.size(); i++) {
+        int s = order[i];
+        SnapshotRecord r;
+        memset(&r, 0, sizeof(r));
+        r.id = store.ids[s];
+        r.descLength = (uint32_t)store.description(s).size();
+        r.descOffset = offset;
+        r.priority = (uint8_t)store.priority(s);
+        r.completed = store.isCompleted(s) ? 1 : 0;
+        offset += r.descLength;
+        ok = fwrite(&r, sizeof(r), 1, f) == 1;
+    }
+    for (size_t i = 0; ok && i < order.size(); i++) {
+        std::string_view d = store.description(order[i]);
+        ok = d.empty() || fwrite(d.data(), 1, d.size(), f) == d.size();
+    }
+    for (size_t i = 0; ok && (h.flags & SNAPSHOT_DEADLINES) && i < order.size(); i++) {
+        int64_t when = store.deadline(order[i]);
+        ok = fwrite(&when, sizeof(when), 1, f) == 1;
+    }
+
+    ok = ok && syncFile(f);
+    ok = (fclose(f) == 0) && ok;
+    bool renamed = false;
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+        renamed = ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) std::remove(tmpPath.c_str());
+    // not durable until the directory entry is: keep the log (false), but the file is the new one
+    ok = ok && syncParentDirectory(path);
+    if (renamed && layout) {
+        std::vector<int> ids;
+        ids.reserve(order.size());
+        for (int s : order) ids.push_back(store.ids[s]);
+        layout->assign(h, ids.data(), nullptr);
+    }
+    return ok;
+}
+
+// position 'f' at a byte offset, which may be past 2 GB
+inline bool seekSnapshot(FILE* f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// one task's record as patchSnapshot() writes it
+struct SnapshotPatch {
+    uint64_t record;
+    uint8_t priority;
+    uint8_t completed;
+    uint8_t removed;
+    int64_t deadline;       // not written for removed records
+};
+
+// overwrite the patched records of the file 'layout' describes, then its
+// header's nextId / flags / logSequence. False, with nothing written, if the
+// file is not the one 'layout' describes (another writer replaced it) or
+// cannot take the patch (an older version; a deadline but no deadline array).
+inline bool patchSnapshot(const std::string& path, SnapshotLayout& layout,
+                          const std::vector<SnapshotPatch>& patches, int nextId, uint64_t logSequence) {
+    const SnapshotHeader& expected = layout.header();
+    if (expected.version != SNAPSHOT_VERSION) return false;
+    bool deadlines = (expected.flags & SNAPSHOT_DEADLINES) != 0;
+    uint64_t removed = layout.removedCount();
+    for (const SnapshotPatch& p : patches) {
+        if (p.record >= expected.count) return false;
+        if (!p.removed && p.deadline != 0 && !deadlines) return false;
+        removed += (uint64_t)p.removed - (uint64_t)layout.isRemoved(p.record);
+    }
+
+    FILE* f = fopen(path.c_str(), "r+b");
+    if (!f) return false;
+    SnapshotHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        h.version != expected.version || h.count != expected.count || h.blobSize != expected.blobSize ||
+        h.logSequence != expected.logSequence) {
+        fclose(f);
+        return false;
+    }
+
+    const uint64_t recordsAt = sizeof(SnapshotHeader);
+    const uint64_t deadlinesAt = recordsAt + h.count * sizeof(SnapshotRecord) + h.blobSize;
+    bool ok = true;
+    for (size_t i = 0; ok && i < patches.size(); i++) {
+        const SnapshotPatch& p = patches[i];
+        const uint8_t fields[3] = { p.priority, p.completed, p.removed };
+        ok = seekSnapshot(f, recordsAt + p.record * sizeof(SnapshotRecord) + offsetof(SnapshotRecord, priority)) &&
+             fwrite(fields, sizeof(fields), 1, f) == 1;
+        if (ok && deadlines && !p.removed) {
+            ok = seekSnapshot(f, deadlinesAt + p.record * sizeof(int64_t)) &&
+                 fwrite(&p.deadline, sizeof(p.deadline), 1, f) == 1;
+        }
+    }
+    // the records reach the disk before the header: until it is written, load()
+    // replays the log from the old sequence. The header is synced too before
+    // the caller empties the log, which until then is the only durable copy.
+    h.nextId = nextId;
+    h.flags = (h.flags & ~SNAPSHOT_REMOVED) | (removed ? SNAPSHOT_REMOVED : 0);
+    h.logSequence = logSequence;
+    ok = ok && syncFile(f);
+    ok = ok && seekSnapshot(f, 0) && fwrite(&h, sizeof(h), 1, f) == 1 && syncFile(f);
+    ok = (fclose(f) == 0) && ok;
+    for (size_t i = 0; ok && i < patches.size(); i++) layout.setRemoved(patches[i].record, patches[i].removed != 0);
+    if (ok) layout.setHeader(h);
+    else layout.clear();    // part of it may be written: the next checkpoint rewrites the file
+    return ok;
+}
+
+#endif
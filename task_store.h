@@ -0,0 +1,406 @@
+#ifndef TASK_STORE_H
+#define TASK_STORE_H
+
+/*
+ * TaskStore - structure-of-arrays storage for tasks
+ *
+ * Every task lives in a "slot". The fields that scans look at (id, priority,
+ * completed/live flags) are kept in their own contiguous arrays, so counting
+ * or filtering streams through a few bytes per task instead of chasing list
+ * nodes. Descriptions live in a separate pool indexed by the same slot and are
+ * only touched when a row is actually printed.
+ *
+ * Slots are handed out in insertion order and are not reused, so walking the
+ * slots from 0 upwards gives the tasks in list order. Released slots stay as
+ * holes until the owner calls compact() with the order it wants to keep.
+ *
+ * The store also keeps running counts (live, completed, per priority) that
+ * every mutator updates, so statistics never need a scan. Debug builds can
+ * cross-check them against a full scan with checkCounters().
+ *
+ * Live slots are also threaded onto one list per priority (in slot order),
+ * so a priority-ordered listing visits every task once and "first K tasks of
+ * priority p" only looks at that bucket. BasicTaskStore<false> leaves the
+ * lists out (8 bytes less per task, no link updates); forEachInPriority() and
+ * topPending() then scan the priority column instead.
+ *
+ * Descriptions are TaskDescriptions (task_string.h): short ones are kept
+ * inline in the column, so most tasks cost no allocation.
+ *
+ * A description can also be "borrowed": a view into memory the owner keeps
+ * alive (e.g. a mapped snapshot file). It stays a view until it is edited.
+ *
+ * Deadlines (seconds since the epoch, 0 = none) are a column of their own
+ * that stays empty until the first one is set, so a list without deadlines
+ * does not pay for it.
+ *
+ * The counts can also be kept per block of slots (SlotRanks, task_page.h)
+ * once buildRanks() was called, which is what paging uses to find a position
+ * in O(log n).
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task_string.h"
+#include "task_page.h"
+
+template <bool PriorityLists>
+struct BasicTaskStore {
+    static constexpr bool hasPriorityLists = PriorityLists;
+
+    // bits in flags[]
+    static constexpr unsigned char LIVE = 1;   // task is in the list (not deleted)
+    static constexpr unsigned char DONE = 2;   // task is completed
+
+    std::vector<int> ids;                    // task id per slot
+    std::vector<unsigned char> priorities;   // 1..5 per slot
+    std::vector<unsigned char> flags;        // LIVE | DONE per slot
+    std::vector<TaskDescription> descriptions; // description pool, indexed by slot
+    std::vector<std::string_view> borrowed;  // views used instead of descriptions[] when
+                                             // set; empty unless addBorrowed() was used
+    std::vector<int64_t> deadlines;          // per slot, 0 = none; empty until one is set
+
+    int liveCount = 0;      // slots with LIVE set
+    int doneCount = 0;      // live slots with DONE set
+    int prioLive[6] = {};   // live tasks per priority (index 1..5)
+    int prioDone[6] = {};   // live completed tasks per priority
+    int freedCount = 0;     // released slots waiting for compact()
+
+    // priority index: one list of live slots per priority, kept in slot order
+    // (empty without PriorityLists, the heads stay -1)
+    std::vector<int> prioNext, prioPrev;                // links per slot, -1 = none
+    int prioHead[6] = { -1, -1, -1, -1, -1, -1 };
+    int prioTail[6] = { -1, -1, -1, -1, -1, -1 };
+
+    SlotRanks ranks;        // empty until buildRanks()
+
+    int slotCount() const { return (int)ids.size(); }
+
+    // append a task, returns its slot
+    int add(int id, std::string_view desc, int priority, bool completed) {
+        ids.push_back(id);
+        priorities.push_back((unsigned char)priority);
+        flags.push_back(completed ? (LIVE | DONE) : LIVE);
+        descriptions.emplace_back(desc);
+        if (!borrowed.empty()) borrowed.push_back(std::string_view());
+        if (!deadlines.empty()) deadlines.push_back(0);
+        if constexpr (PriorityLists) {
+            prioNext.push_back(-1);
+            prioPrev.push_back(-1);
+        }
+        countIn((int)ids.size() - 1);
+        return (int)ids.size() - 1;
+    }
+
+    // append a task whose description points at memory the caller keeps alive
+    int addBorrowed(int id, std::string_view desc, int priority, bool completed) {
+        int slot = add(id, std::string_view(), priority, completed);
+        if (borrowed.size() < ids.size()) borrowed.resize(ids.size());
+        borrowed[slot] = desc;
+        return slot;
+    }
+
+    bool isLive(int slot) const { return (flags[slot] & LIVE) != 0; }
+    bool isCompleted(int slot) const { return (flags[slot] & DONE) != 0; }
+    int priority(int slot) const { return priorities[slot]; }
+    std::string_view description(int slot) const {
+        if (!borrowed.empty() && borrowed[slot].data() != nullptr) return borrowed[slot];
+        return descriptions[slot];
+    }
+    int64_t deadline(int slot) const { return deadlines.empty() ? 0 : deadlines[slot]; }
+    bool hasDeadlines() const { return !deadlines.empty(); }
+
+    void setCompleted(int slot, bool done) {
+        if (isCompleted(slot) == done) return;
+        if (isLive(slot)) {
+            int d = done ? 1 : -1;
+            doneCount += d;
+            prioDone[priorities[slot]] += d;
+            if (ranks.isBuilt()) ranks.add(slot, RANK_DONE, d);
+        }
+        if (done) flags[slot] |= DONE;
+        else flags[slot] &= (unsigned char)~DONE;
+    }
+    void setPriority(int slot, int priority) {
+        bool live = isLive(slot);
+        if (live) countOut(slot);
+        priorities[slot] = (unsigned char)priority;
+        if (live) countIn(slot);
+    }
+    void setDescription(int slot, std::string_view desc) {
+        descriptions[slot].assign(desc.data(), desc.size());
+        if (!borrowed.empty()) borrowed[slot] = std::string_view();
+    }
+    void setDeadline(int slot, int64_t when) {
+        if (deadlines.empty()) {
+            if (when == 0) return;
+            deadlines.assign(ids.size(), 0);
+        }
+        deadlines[slot] = when;
+    }
+
+    // exchange the description with 'other' without copying the text
+    // (a borrowed one is copied into the slot first)
+    void swapDescription(int slot, TaskDescription& other) {
+        if (!borrowed.empty() && borrowed[slot].data() != nullptr) setDescription(slot, borrowed[slot]);
+        descriptions[slot].swap(other);
+    }
+
+    // take a task out of the scans but keep its data, so it can be revived (undo)
+    void hide(int slot) {
+        if (!isLive(slot)) return;
+        countOut(slot);
+        flags[slot] &= (unsigned char)~LIVE;
+    }
+    void revive(int slot) {
+        if (isLive(slot)) return;
+        flags[slot] |= LIVE;
+        countIn(slot);
+    }
+
+    // forget a slot for good; the hole goes away on the next compact()
+    void release(int slot) {
+        hide(slot);
+        flags[slot] = 0;
+        ids[slot] = 0;
+        TaskDescription().swap(descriptions[slot]);
+        if (!borrowed.empty()) borrowed[slot] = std::string_view();
+        if (!deadlines.empty()) deadlines[slot] = 0;
+        freedCount++;
+    }
+
+    // rough memory one slot keeps alive: its entry in every column plus the
+    // description it owns (a borrowed one costs nothing here)
+    size_t slotBytes(int slot) const {
+        size_t columns = sizeof(int) * (PriorityLists ? 3 : 1) + 2 + sizeof(TaskDescription) +
+                         (borrowed.empty() ? 0 : sizeof(std::string_view)) + (deadlines.empty() ? 0 : sizeof(int64_t));
+        return columns + descriptionHeapBytes(descriptions[slot]);
+    }
+
+    // worth compacting once holes outnumber the live tasks
+    bool needsCompact() const { return freedCount > 1024 && freedCount > liveCount; }
+
+    // rebuild the arrays keeping only the slots in 'order', in that order:
+    // new slot i holds what was in slot order[i]
+    void compact(const std::vector<int>& order) {
+        std::vector<int> newIds(order.size());
+        std::vector<unsigned char> newPrio(order.size());
+        std::vector<unsigned char> newFlags(order.size());
+        std::vector<TaskDescription> newDesc(order.size());
+        std::vector<std::string_view> newBorrowed(borrowed.empty() ? 0 : order.size());
+        std::vector<int64_t> newDeadlines(deadlines.empty() ? 0 : order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            int s = order[i];
+            newIds[i] = ids[s];
+            newPrio[i] = priorities[s];
+            newFlags[i] = flags[s];
+            newDesc[i].swap(descriptions[s]);
+            if (!borrowed.empty()) newBorrowed[i] = borrowed[s];
+            if (!deadlines.empty()) newDeadlines[i] = deadlines[s];
+        }
+        ids.swap(newIds);
+        priorities.swap(newPrio);
+        flags.swap(newFlags);
+        descriptions.swap(newDesc);
+        borrowed.swap(newBorrowed);
+        deadlines.swap(newDeadlines);
+        if constexpr (PriorityLists) {
+            prioNext.assign(order.size(), -1);
+            prioPrev.assign(order.size(), -1);
+        }
+        freedCount = 0;
+        recount();
+    }
+
+    void reserve(size_t n) {
+        ids.reserve(n);
+        priorities.reserve(n);
+        flags.reserve(n);
+        descriptions.reserve(n);
+        if (!deadlines.empty()) deadlines.reserve(n);
+        if constexpr (PriorityLists) {
+            prioNext.reserve(n);
+            prioPrev.reserve(n);
+        }
+    }
+
+    void clear() {
+        ids.clear();
+        priorities.clear();
+        flags.clear();
+        descriptions.clear();
+        borrowed.clear();
+        deadlines.clear();
+        prioNext.clear();
+        prioPrev.clear();
+        ranks.clear();
+        freedCount = 0;
+        recount();
+    }
+
+    // start keeping per-block counts for paging (see task_page.h), O(n);
+    // kept up to date until clear()
+    void buildRanks() {
+        ranks.build(slotCount(), [&](int s, SlotRanks::Counts& c) {
+            if (!isLive(s)) return;
+            c[RANK_LIVE]++;
+            c[RANK_DONE] += isCompleted(s);
+            c[RANK_PRIORITY + priorities[s] - 1]++;
+        });
+    }
+
+    // number of live, completed tasks (streams the flags array only)
+    int countCompleted() const {
+        int count = 0;
+        const unsigned char* f = flags.data();
+        for (size_t s = 0, n = flags.size(); s < n; s++) {
+            count += (f[s] & (LIVE | DONE)) == (LIVE | DONE);
+        }
+        return count;
+    }
+
+    // rebuild every counter and the priority lists from a full scan
+    void recount() {
+        bool ranked = ranks.isBuilt();
+        ranks.clear();
+        liveCount = doneCount = 0;
+        for (int p = 0; p < 6; p++) {
+            prioLive[p] = prioDone[p] = 0;
+            prioHead[p] = prioTail[p] = -1;
+        }
+        for (int s = 0; s < slotCount(); s++) {
+            if (isLive(s)) countIn(s);
+        }
+        if (ranked) buildRanks();
+    }
+
+    // debug check: the running counters must match a full scan
+    void checkCounters() const {
+#ifndef NDEBUG
+        int live = 0, done = 0, pl[6] = {}, pd[6] = {};
+        for (int s = 0; s < slotCount(); s++) {
+            if (!isLive(s)) continue;
+            live++;
+            pl[priorities[s]]++;
+            if (isCompleted(s)) { done++; pd[priorities[s]]++; }
+        }
+        assert(live == liveCount);
+        assert(done == doneCount);
+        for (int p = 0; p < 6; p++) {
+            assert(pl[p] == prioLive[p]);
+            assert(pd[p] == prioDone[p]);
+            if (!PriorityLists) continue;
+            int inBucket = 0, last = -1;
+            for (int s = prioHead[p]; s != -1; s = prioNext[s]) {
+                assert(s > last && isLive(s) && priorities[s] == p);
+                last = s;
+                inBucket++;
+            }
+            assert(inBucket == prioLive[p] && last == prioTail[p]);
+        }
+#endif
+    }
+
+    // fn(slot) for every live slot of priority p in slot order; return false
+    // from fn to stop early
+    template <class Fn>
+    void forEachInPriority(int p, Fn fn) const {
+        if constexpr (PriorityLists) {
+            for (int s = prioHead[p]; s != -1; s = prioNext[s]) {
+                if (!fn(s)) return;
+            }
+        }
+        else {
+            int left = prioLive[p];
+            const unsigned char* pr = priorities.data();
+            for (int s = 0, n = slotCount(); s < n && left > 0; s++) {
+                if (pr[s] != p || !isLive(s)) continue;
+                left--;
+                if (!fn(s)) return;
+            }
+        }
+    }
+
+    // first (up to) k live, pending slots, walking the buckets in the order given
+    // e.g. order {1,2,3,4,5} when 1 is the most urgent priority
+    std::vector<int> topPending(int k, const int (&order)[5]) const {
+        std::vector<int> result;
+        for (int i = 0; i < 5 && (int)result.size() < k; i++) {
+            int p = order[i];
+            if (prioLive[p] == prioDone[p]) continue;   // nothing pending here
+            forEachInPriority(p, [&](int s) {
+                if (!isCompleted(s)) result.push_back(s);
+                return (int)result.size() < k;
+            });
+        }
+        return result;
+    }
+
+private:
+    // add / remove a live slot's contribution to the counters and priority lists
+    void countIn(int slot) {
+        int p = priorities[slot];
+        liveCount++;
+        prioLive[p]++;
+        if (isCompleted(slot)) { doneCount++; prioDone[p]++; }
+        if constexpr (PriorityLists) bucketLink(slot);
+        if (ranks.isBuilt()) {
+            if (!ranks.covers(slot)) buildRanks();   // grown past the tree, rebuild it twice as big
+            else rankSlot(slot, 1);
+        }
+    }
+    void countOut(int slot) {
+        int p = priorities[slot];
+        liveCount--;
+        prioLive[p]--;
+        if (isCompleted(slot)) { doneCount--; prioDone[p]--; }
+        if constexpr (PriorityLists) bucketUnlink(slot);
+        if (ranks.isBuilt()) rankSlot(slot, -1);
+    }
+    void rankSlot(int slot, int d) {
+        ranks.add(slot, RANK_LIVE, d);
+        if (isCompleted(slot)) ranks.add(slot, RANK_DONE, d);
+        ranks.add(slot, RANK_PRIORITY + priorities[slot] - 1, d);
+    }
+
+    // put a slot into its priority list, keeping the list in slot order.
+    // New tasks are the last slot, so they append in O(1); a revived or
+    // re-prioritised slot looks back through the dense columns for the
+    // nearest earlier slot in the same bucket.
+    void bucketLink(int slot) {
+        int p = priorities[slot];
+        int before = prioTail[p];
+        if (before > slot) {
+            before = -1;                // in front of the current head...
+            if (prioHead[p] < slot) {   // ...unless it belongs in the middle
+                before = slot - 1;
+                while (!(priorities[before] == p && isLive(before))) before--;
+            }
+        }
+
+        int after = (before == -1) ? prioHead[p] : prioNext[before];
+        prioPrev[slot] = before;
+        prioNext[slot] = after;
+        if (before == -1) prioHead[p] = slot;
+        else prioNext[before] = slot;
+        if (after == -1) prioTail[p] = slot;
+        else prioPrev[after] = slot;
+    }
+    void bucketUnlink(int slot) {
+        int p = priorities[slot];
+        int before = prioPrev[slot], after = prioNext[slot];
+        if (before == -1) prioHead[p] = after;
+        else prioNext[before] = after;
+        if (after == -1) prioTail[p] = before;
+        else prioPrev[after] = before;
+        prioPrev[slot] = prioNext[slot] = -1;
+    }
+};
+
+// what both programs use; the lean engine variant (task_policy.h) drops the lists
+using TaskStore = BasicTaskStore<true>;
+
+#endif
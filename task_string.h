@@ -0,0 +1,159 @@
+#ifndef TASK_STRING_H
+#define TASK_STRING_H
+
+/*
+ * InlineString - description storage with a fixed inline buffer
+ *
+ * An InlineString<Bytes> is exactly Bytes bytes. Text of up to Bytes - 1
+ * bytes is kept inside the object; longer text goes to one heap block, sized
+ * to fit and reused while it is big enough. The last byte says which: for
+ * inline text it holds the unused inline capacity (so a full buffer ends in
+ * a 0), for heap text it is HEAP.
+ *
+ * Most task titles are well under 47 bytes, so with the default 48 bytes a
+ * store slot costs no allocation at all, where std::string (15 bytes inline
+ * in libstdc++) allocates for anything longer than a few words. Nothing
+ * points into the object itself, so moves and swaps are a copy of the bytes
+ * and never allocate; copies only allocate for heap text.
+ *
+ * The text is not NUL-terminated; read it through data()/size() or as a
+ * std::string_view.
+ *
+ * TaskDescription is what TaskStore and the undo history keep:
+ * InlineString<TASK_DESC_BYTES>, 48 bytes by default. Build with
+ * -DTASK_DESC_BYTES=0 to use plain std::string instead.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#ifndef TASK_DESC_BYTES
+#define TASK_DESC_BYTES 48
+#endif
+
+template <size_t Bytes>
+class InlineString {
+    static_assert(Bytes >= 24 && Bytes <= 128, "room for the heap fields and the tag, and a tag below HEAP");
+
+public:
+    static constexpr size_t INLINE_CAPACITY = Bytes - 1;
+
+    InlineString() { setInlineSize(0); }
+    explicit InlineString(std::string_view s) {
+        setInlineSize(0);
+        assign(s.data(), s.size());
+    }
+    InlineString(const InlineString& other) {
+        setInlineSize(0);
+        assign(other.data(), other.size());
+    }
+    InlineString(InlineString&& other) noexcept {
+        std::memcpy(raw, other.raw, Bytes);
+        other.setInlineSize(0);
+    }
+    ~InlineString() { release(); }
+
+    InlineString& operator=(const InlineString& other) {
+        if (this != &other) assign(other.data(), other.size());
+        return *this;
+    }
+    InlineString& operator=(InlineString&& other) noexcept {
+        if (this != &other) {
+            release();
+            std::memcpy(raw, other.raw, Bytes);
+            other.setInlineSize(0);
+        }
+        return *this;
+    }
+
+    // 's' may point into this string
+    void assign(const char* s, size_t n) {
+        if (n <= INLINE_CAPACITY) {
+            char* old = isHeap() ? heap().ptr : nullptr;
+            if (n) std::memmove(raw, s, n);     // an empty view may have no data()
+            setInlineSize(n);
+            delete[] old;
+            return;
+        }
+        if (isHeap() && heap().cap >= n) {
+            Heap h = heap();
+            std::memmove(h.ptr, s, n);
+            h.size = (uint32_t)n;
+            setHeap(h);
+            return;
+        }
+        char* p = new char[n];
+        std::memcpy(p, s, n);
+        release();
+        setHeap(Heap{ p, (uint32_t)n, (uint32_t)n });
+    }
+
+    void clear() {
+        release();
+        setInlineSize(0);
+    }
+
+    void swap(InlineString& other) noexcept {
+        char tmp[Bytes];
+        std::memcpy(tmp, raw, Bytes);
+        std::memcpy(raw, other.raw, Bytes);
+        std::memcpy(other.raw, tmp, Bytes);
+    }
+
+    const char* data() const { return isHeap() ? heap().ptr : raw; }
+    size_t size() const { return isHeap() ? heap().size : INLINE_CAPACITY - tag(); }
+    bool empty() const { return size() == 0; }
+    bool isHeap() const { return tag() == HEAP; }
+    size_t heapBytes() const { return isHeap() ? heap().cap : 0; }
+
+    operator std::string_view() const { return std::string_view(data(), size()); }
+
+private:
+    static constexpr unsigned char HEAP = 0xFF;
+
+    struct Heap {
+        char* ptr;
+        uint32_t size;
+        uint32_t cap;
+    };
+
+    unsigned char tag() const { return (unsigned char)raw[Bytes - 1]; }
+    void setInlineSize(size_t n) { raw[Bytes - 1] = (char)(unsigned char)(INLINE_CAPACITY - n); }
+
+    // the heap fields sit at the start of raw; copied in and out so there is no type punning
+    Heap heap() const {
+        Heap h;
+        std::memcpy(&h, raw, sizeof(h));
+        return h;
+    }
+    void setHeap(const Heap& h) {
+        std::memcpy(raw, &h, sizeof(h));
+        raw[Bytes - 1] = (char)HEAP;
+    }
+
+    void release() {
+        if (isHeap()) delete[] heap().ptr;
+    }
+
+    alignas(char*) char raw[Bytes];
+};
+
+template <size_t Bytes>
+inline size_t descriptionHeapBytes(const InlineString<Bytes>& s) { return s.heapBytes(); }
+
+// what a std::string has allocated beyond its own object
+inline size_t descriptionHeapBytes(const std::string& s) {
+    static const size_t local = std::string().capacity();
+    return s.capacity() > local ? s.capacity() + 1 : 0;
+}
+
+#if TASK_DESC_BYTES > 0
+using TaskDescription = InlineString<TASK_DESC_BYTES>;
+#else
+using TaskDescription = std::string;
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef TASK_TEXT_H
+#define TASK_TEXT_H
+
+/*
+ * Streaming parser for the text task format (tasks.txt)
+ *
+ *   id|description|priority|completed\n
+ *   id|description|priority|completed|deadline\n
+ *
+ * The deadline (seconds since the epoch) is only written for tasks that have
+ * one; a line without it has none.
+ *
+ * The file is read in large chunks and each line is split in place; the
+ * numbers are converted with std::from_chars, so parsing allocates nothing
+ * per line. A line that does not parse is skipped and reported with its line
+ * number instead of throwing. Ids must be positive; whether an id repeats is
+ * for the caller to check, with the record's line number to report it.
+ *
+ * writeTaskLines() writes the format, so every writer agrees with the parser.
+ *
+ * parseTaskBuffer() does the same over a file already in memory (e.g. mapped
+ * with MappedFile, task_snapshot.h); its descriptions then point into that
+ * memory and stay valid as long as it does.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct TextTaskRecord {
+    int id;
+    std::string_view description;   // points into the read buffer (or the parsed memory), copy it to keep it
+    int priority;                   // as written, the caller decides what is valid
+    bool completed;
+    int64_t deadline = 0;           // 0 = none
+    size_t line = 0;                // 1-based, for checks only the caller can make
+};
+
+struct ParseError {
+    size_t line;        // 1-based
+    const char* reason;
+};
+
+// parse one whole number that must fill [b, e)
+template <class Int>
+inline bool parseIntField(const char* b, const char* e, Int& out) {
+    if (b == e) return false;
+    std::from_chars_result r = std::from_chars(b, e, out);
+    return r.ec == std::errc() && r.ptr == e;
+}
+
+// split one line (without its '\n') into a record.
+// Returns nullptr on success, otherwise the reason the line was rejected.
+inline const char* parseTaskLine(const char* b, const char* e, TextTaskRecord& out) {
+    if (e > b && e[-1] == '\r') e--;                  // file written on Windows
+    const char* p1 = (const char*)memchr(b, '|', (size_t)(e - b));
+    if (!p1) return "missing fields";
+    const char* p2 = (const char*)memchr(p1 + 1, '|', (size_t)(e - p1 - 1));
+    if (!p2) return "missing fields";
+    const char* p3 = (const char*)memchr(p2 + 1, '|', (size_t)(e - p2 - 1));
+    if (!p3) return "missing fields";
+
+    const char* p4 = (const char*)memchr(p3 + 1, '|', (size_t)(e - p3 - 1));
+
+    int done;
+    if (!parseIntField(b, p1, out.id)) return "bad task id";
+    if (out.id <= 0) return "task id must be positive";
+    if (!parseIntField(p2 + 1, p3, out.priority)) return "bad priority";
+    if (!parseIntField(p3 + 1, p4 ? p4 : e, done)) return "bad completed flag";
+    out.deadline = 0;
+    if (p4 && !parseIntField(p4 + 1, e, out.deadline)) return "bad deadline";
+    out.description = std::string_view(p1 + 1, (size_t)(p2 - p1 - 1));
+    out.completed = (done != 0);
+    return nullptr;
+}
+
+// read 'f' chunk by chunk and call onLine(const char* b, const char* e, size_t lineNo)
+// for every line, without its '\n'. The pointers are only valid during the call.
+template <class OnLine>
+void forEachLine(FILE* f, OnLine onLine, size_t chunkSize = 1 << 20) {
+    std::vector<char> buf(chunkSize);
+    size_t kept = 0;        // bytes of an unfinished line carried over from the last chunk
+    size_t lineNo = 0;
+    bool eof = false;
+
+    while (!eof) {
+        if (kept == buf.size()) buf.resize(buf.size() * 2);     // a very long line
+        size_t got = fread(buf.data() + kept, 1, buf.size() - kept, f);
+        if (got == 0) eof = true;
+        const char* p = buf.data();
+        const char* end = buf.data() + kept + got;
+
+        while (p < end) {
+            const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+            if (!nl) {
+                if (!eof) break;    // finish this line with the next chunk
+                nl = end;           // last line without a newline
+            }
+            onLine(p, nl, ++lineNo);
+            p = nl + 1;
+        }
+
+        kept = (p < end) ? (size_t)(end - p) : 0;
+        if (kept) memmove(buf.data(), p, kept);
+    }
+}
+
+// the same for [data, data + size) already in memory
+template <class OnLine>
+void forEachLineIn(const char* data, size_t size, OnLine onLine) {
+    const char* p = data;
+    const char* end = data + size;
+    size_t lineNo = 0;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        onLine(p, nl, ++lineNo);
+        p = nl + 1;
+    }
+}
+
+// onLine for the parsers below: skip empty lines, report bad ones
+template <class OnTask>
+auto taskLineParser(OnTask& onTask, std::vector<ParseError>& errors) {
+    return [&onTask, &errors](const char* b, const char* e, size_t lineNo) {
+        if (b == e || (e == b + 1 && *b == '\r')) return;
+        TextTaskRecord rec;
+        rec.line = lineNo;
+        const char* reason = parseTaskLine(b, e, rec);
+        if (reason) errors.push_back(ParseError{ lineNo, reason });
+        else onTask(rec);
+    };
+}
+
+// read 'path' and call onTask(const TextTaskRecord&) for every good line;
+// bad lines are appended to 'errors'. Empty lines are ignored.
+// Returns false only if the file cannot be opened.
+template <class OnTask>
+bool parseTaskFile(const std::string& path, OnTask onTask, std::vector<ParseError>& errors,
+                   size_t chunkSize = 1 << 20) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    forEachLine(f, taskLineParser(onTask, errors), chunkSize);
+    fclose(f);
+    return true;
+}
+
+// parseTaskFile() over a whole file in memory; the descriptions point into it
+template <class OnTask>
+void parseTaskBuffer(const char* data, size_t size, OnTask onTask, std::vector<ParseError>& errors) {
+    forEachLineIn(data, size, taskLineParser(onTask, errors));
+}
+
+// the store's 'slots' in the format above; a '|' in a description becomes a space
+template <class Store>
+void writeTaskLines(std::ostream& out, const Store& store, const std::vector<int>& slots) {
+    std::string desc;
+    for (int s : slots) {
+        desc.assign(store.description(s));
+        std::replace(desc.begin(), desc.end(), '|', ' ');
+        out << store.ids[s] << "|" << desc << "|" << store.priority(s) << "|" << (store.isCompleted(s) ? 1 : 0);
+        if (int64_t when = store.deadline(s)) out << "|" << when;
+        out << "\n";
+    }
+}
+
+#endif
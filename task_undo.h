@@ -0,0 +1,253 @@
+#ifndef TASK_UNDO_H
+#define TASK_UNDO_H
+
+/*
+ * UndoJournal - bounded undo / redo history
+ *
+ * Every user-visible change is one step; a step is a run of small deltas:
+ *
+ *   UNDO_EDIT      id + the description and/or priority the task does NOT
+ *                  have right now (only the fields that changed)
+ *   UNDO_COMPLETE  id + the completed state the task does not have right now
+ *   UNDO_DEADLINE  id + the deadline the task does not have right now
+ *   UNDO_DELETE    id + the store slot the deleted task is hidden in + the id
+ *                  of the task that was before it in the list
+ *
+ * Edit, complete and deadline deltas swap their value with the task's on both undo and
+ * redo, so one copy serves both directions; an edit's old description is
+ * moved in, not copied. A delete keeps the task's fields
+ * in its (hidden) store slot, nothing is copied. Steps are undone newest
+ * first (and a step's deltas in reverse), so when a delete is undone its
+ * predecessor is exactly where it was again, and linking the task back behind
+ * it restores the original order without a search. Bulk operations such as
+ * clearing every completed task are one step with many deltas, undone and
+ * redone as a whole.
+ *
+ * The history is bounded twice: at most maxSteps steps (a ring of step
+ * records over one deque of deltas) and at most budgetBytes of estimated
+ * memory. When either is exceeded the oldest steps are dropped and the owner
+ * is handed the slots of their deleted tasks to release for good. A step
+ * that alone exceeds the budget is dropped straight away (it cannot be undone).
+ *
+ * Recording a new change throws away the redo steps, as usual.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "task_string.h"
+
+enum UndoKind : uint8_t {
+    UNDO_EDIT,
+    UNDO_COMPLETE,
+    UNDO_DELETE,
+    UNDO_DEADLINE
+};
+
+struct UndoDelta {
+    UndoKind kind;
+    bool completed = false;     // COMPLETE: the other state
+    bool hasText = false;       // EDIT: text holds the other description
+    uint8_t priority = 0;       // EDIT: the other priority, 0 = unchanged
+    int id = 0;
+    int slot = -1;              // DELETE: where the task's fields are kept
+    int after = 0;              // DELETE: id of the task before it, 0 = it was the head
+    int64_t deadline = 0;       // DEADLINE: the other deadline, 0 = none
+    TaskDescription text;
+};
+
+class UndoJournal {
+public:
+    static constexpr size_t DEFAULT_STEPS = 1000;
+    static constexpr size_t DEFAULT_BUDGET = 32u << 20;
+
+    explicit UndoJournal(size_t maxSteps = DEFAULT_STEPS, size_t budgetBytes = DEFAULT_BUDGET) {
+        setLimits(maxSteps, budgetBytes);
+    }
+
+    // starts an empty history, so call it before anything is recorded
+    void setLimits(size_t maxSteps, size_t budgetBytes) {
+        ring.assign(maxSteps > 0 ? maxSteps : 1, Step());
+        first = steps = cursor = 0;
+        deltas.clear();
+        dropped = 0;
+        bytes = 0;
+        budget = budgetBytes;
+    }
+
+    size_t maxSteps() const { return ring.size(); }
+    size_t budgetBytes() const { return budget; }
+    size_t usedBytes() const { return bytes; }
+    bool canUndo() const { return cursor > 0; }
+    bool canRedo() const { return cursor < steps; }
+
+    // forget everything without releasing anything (the owner clears the store too)
+    void clear() {
+        first = steps = cursor = 0;
+        deltas.clear();
+        dropped = 0;
+        bytes = 0;
+    }
+
+    // ---- recording: begin(), any number of record*(), commit() ----
+
+    void begin() {
+        pendingStart = deltas.size();
+        pendingBytes = 0;
+    }
+
+    // oldText is only kept if textChanged; oldPriority 0 = priority not changed
+    void recordEdit(int id, bool textChanged, TaskDescription&& oldText, int oldPriority) {
+        UndoDelta& d = push(UNDO_EDIT, id);
+        if (textChanged) {
+            d.hasText = true;
+            d.text = std::move(oldText);
+        }
+        d.priority = (uint8_t)oldPriority;
+        pendingBytes += descriptionHeapBytes(d.text);
+    }
+
+    void recordComplete(int id, bool wasCompleted) {
+        push(UNDO_COMPLETE, id).completed = wasCompleted;
+    }
+
+    void recordDeadline(int id, int64_t oldDeadline) {
+        push(UNDO_DEADLINE, id).deadline = oldDeadline;
+    }
+
+    // heldBytes: what the hidden slot keeps alive (its description etc.)
+    void recordDelete(int id, int slot, int after, size_t heldBytes) {
+        UndoDelta& d = push(UNDO_DELETE, id);
+        d.slot = slot;
+        d.after = after;
+        pendingBytes += heldBytes;
+    }
+
+    // close the step; release(slot) is called for the deleted tasks of every
+    // step that no longer fits. Returns false if nothing was recorded.
+    template <class Release>
+    bool commit(Release release) {
+        size_t count = deltas.size() - pendingStart;
+        if (count == 0) return false;
+        if (steps == ring.size()) dropOldest(release);
+        ring[(first + steps) % ring.size()] = Step{ count, pendingBytes, dropped + pendingStart };
+        steps++;
+        cursor = steps;
+        bytes += pendingBytes;
+        while (steps > 0 && bytes > budget) dropOldest(release);
+        return true;
+    }
+
+    // ---- replaying ----
+
+    // apply(UndoDelta&, bool undoing) for the deltas of the last step, newest
+    // first. Edit/complete/deadline deltas must be swapped with the task's state.
+    template <class Apply>
+    bool undo(Apply apply) {
+        if (!canUndo()) return false;
+        cursor--;
+        size_t end = deltaStart(cursor) + ring[index(cursor)].count;
+        for (size_t i = end; i-- > deltaStart(cursor);) apply(deltas[i], true);
+        return true;
+    }
+
+    // the step undo() last reverted, oldest delta first
+    template <class Apply>
+    bool redo(Apply apply) {
+        if (!canRedo()) return false;
+        size_t start = deltaStart(cursor);
+        for (size_t i = start, end = start + ring[index(cursor)].count; i < end; i++) apply(deltas[i], false);
+        cursor++;
+        return true;
+    }
+
+    // fn(int& slot) for every kept slot (e.g. to renumber after compacting)
+    template <class Fn>
+    void forEachSlot(Fn fn) {
+        for (UndoDelta& d : deltas) {
+            if (d.kind == UNDO_DELETE) fn(d.slot);
+        }
+    }
+
+    // fn(slot) for the slots of deleted tasks that are still hidden
+    // (steps not undone), i.e. the slots the journal keeps alive
+    template <class Fn>
+    void forEachHiddenSlot(Fn fn) const {
+        for (size_t i = 0, end = deltaStart(cursor); i < end; i++) {
+            if (deltas[i].kind == UNDO_DELETE) fn(deltas[i].slot);
+        }
+    }
+
+private:
+    struct Step {
+        size_t count = 0;       // deltas in this step
+        size_t bytes = 0;       // estimated memory it keeps alive
+        size_t start = 0;       // its first delta, counting every delta ever dropped
+    };
+
+    UndoDelta& push(UndoKind kind, int id) {
+        if (cursor < steps) dropRedo();
+        deltas.emplace_back();
+        UndoDelta& d = deltas.back();
+        d.kind = kind;
+        d.id = id;
+        pendingBytes += sizeof(UndoDelta);
+        return d;
+    }
+
+    size_t index(size_t step) const { return (first + step) % ring.size(); }
+
+    // deltas of steps [0, step) come first in the deque; O(1), undo must
+    // not cost more with a longer history
+    size_t deltaStart(size_t step) const {
+        if (step < steps) return ring[index(step)].start - dropped;
+        if (steps == 0) return 0;
+        const Step& last = ring[index(steps - 1)];
+        return last.start - dropped + last.count;
+    }
+
+    // called before the first delta of a new step; the redo steps describe
+    // tasks that are live again, so there is nothing to release
+    void dropRedo() {
+        size_t keep = deltaStart(cursor);
+        for (size_t s = cursor; s < steps; s++) bytes -= ring[index(s)].bytes;
+        deltas.erase(deltas.begin() + (std::ptrdiff_t)keep, deltas.end());
+        pendingStart = keep;
+        steps = cursor;
+    }
+
+    // only called from commit(), when no step is undone, so every dropped
+    // delete still holds a hidden slot
+    template <class Release>
+    void dropOldest(Release release) {
+        Step& s = ring[first];
+        for (size_t i = 0; i < s.count; i++) {
+            if (deltas.front().kind == UNDO_DELETE) release(deltas.front().slot);
+            deltas.pop_front();
+        }
+        bytes -= s.bytes;
+        dropped += s.count;
+        pendingStart = pendingStart >= s.count ? pendingStart - s.count : 0;
+        s = Step();
+        first = (first + 1) % ring.size();
+        steps--;
+        cursor--;
+    }
+
+    std::vector<Step> ring;         // steps[first], steps[first + 1], ... (mod size)
+    size_t first = 0;               // oldest step
+    size_t steps = 0;               // steps in the ring
+    size_t cursor = 0;              // steps [0, cursor) can be undone, [cursor, steps) redone
+    std::deque<UndoDelta> deltas;   // every step's deltas, oldest step first
+    size_t dropped = 0;             // deltas popped off the front so far
+    size_t bytes = 0;
+    size_t budget = DEFAULT_BUDGET;
+    size_t pendingStart = 0;        // first delta of the step being recorded
+    size_t pendingBytes = 0;
+};
+
+#endif